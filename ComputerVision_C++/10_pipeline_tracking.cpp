@@ -0,0 +1,219 @@
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "1_load_images_videos_webcam.h"
+#include "9_pose_tracking.h"
+#include "10_pipeline_tracking.h"
+
+
+// A decoded frame on its way to a worker, by its FramePool slot; slot == -1 marks the end of the stream
+struct FrameTask {
+    int index = -1;
+    int slot = -1;
+};
+
+// A tracked position on its way to the reorder stage; index == -1 means a worker has finished
+struct PositionResult {
+    int index = -1;
+    cv::Point2f position;
+};
+
+
+// Raise a "max depth" statistic if the current depth is larger
+static void updateMaxDepth(std::atomic<std::size_t>& maxDepth, std::size_t depth) {
+    std::size_t current = maxDepth.load(std::memory_order_relaxed);
+    while (depth > current && !maxDepth.compare_exchange_weak(current, depth, std::memory_order_relaxed)) {
+    }
+}
+
+
+/**
+ * @brief Creates a tracking pipeline for an object within the given HSV color range.
+ *
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param numWorkers Number of worker threads; 0 uses all cores except the ones of the decode and reorder stages.
+ * @param queueCapacity Capacity of the frame and result queues; bounds the number of frames in flight.
+ */
+TrackingPipeline::TrackingPipeline(const cv::Point3f& lower, const cv::Point3f& upper, int numWorkers, std::size_t queueCapacity)
+    : lower_(lower), upper_(upper), numWorkers_(numWorkers), queueCapacity_(std::max<std::size_t>(queueCapacity, 2)) {
+    if (numWorkers_ <= 0) {
+        numWorkers_ = std::max(1, cv::getNumberOfCPUs() - 2);
+    }
+}
+
+
+/**
+ * @brief Runs decode, tracking and reordering concurrently over a video.
+ *
+ * The decode thread reads every frame into a buffer borrowed from a FramePool and pushes it on a bounded
+ * lock-free queue. Worker threads pop frames, compute the object position (findObjectPositionInColorRange(),
+ * which gives the same result as applyColorMask() + findObjectPosition() without building the mask), give the
+ * frame back to the pool and push the result on a second queue. The calling thread restores frame order and
+ * calls onPosition for every frame. Memory stays bounded because the decoder blocks while all pooled frames
+ * are in flight.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param onPosition Called in frame order with the frame index and the object position; return false to stop.
+ * @return int The number of positions emitted, or -1 if the video is not opened.
+ */
+int TrackingPipeline::run(cv::VideoCapture& video, const std::function<bool(int, const cv::Point2f&)>& onPosition) {
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source." << std::endl;
+        return -1;
+    }
+
+    cv::Size frameSize(static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    FramePool framePool(queueCapacity_ + numWorkers_, frameSize, CV_8UC3);
+
+    BoundedQueue<FrameTask> frameQueue(queueCapacity_);
+    BoundedQueue<PositionResult> resultQueue(queueCapacity_);
+    std::atomic<bool> stop{ false };
+
+    maxFrameQueueDepth_ = 0;
+    maxResultQueueDepth_ = 0;
+    maxReorderBufferDepth_ = 0;
+
+    // decode stage
+    std::thread decoder([&] {
+        int index = 0;
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            std::size_t slot = framePool.acquire();
+            if (!readFrame(video, framePool.frame(slot))) {
+                framePool.release(slot);
+                break;
+            }
+
+            frameQueue.push(FrameTask{ index++, static_cast<int>(slot) });
+
+            std::size_t depth = frameQueue.size();
+            frameQueueDepth_.store(depth, std::memory_order_relaxed);
+            updateMaxDepth(maxFrameQueueDepth_, depth);
+        }
+
+        // one end marker per worker
+        for (int i = 0; i < numWorkers_; i++) {
+            frameQueue.push(FrameTask());
+        }
+    });
+
+    // tracking stage
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numWorkers_; i++) {
+        workers.emplace_back([&] {
+            cv::Mat mask;
+
+            while (true) {
+                FrameTask task;
+                frameQueue.pop(task);
+                frameQueueDepth_.store(frameQueue.size(), std::memory_order_relaxed);
+
+                if (task.slot < 0) {
+                    break;
+                }
+
+                const cv::Mat& frame = framePool.frame(task.slot);
+                PositionResult result;
+                result.index = task.index;
+                if (frame.type() == CV_8UC3) {
+                    result.position = findObjectPositionInColorRange(frame, lower_, upper_);
+                }
+                else {
+                    mask = applyColorMask(frame, lower_, upper_);
+                    result.position = findObjectPosition(mask);
+                }
+                framePool.release(task.slot);
+
+                resultQueue.push(result);
+
+                std::size_t depth = resultQueue.size();
+                resultQueueDepth_.store(depth, std::memory_order_relaxed);
+                updateMaxDepth(maxResultQueueDepth_, depth);
+            }
+
+            resultQueue.push(PositionResult());
+        });
+    }
+
+    // reorder stage: results arrive in any order, emit them by frame index
+    std::map<int, cv::Point2f> pending;
+    int nextIndex = 0;
+    int finishedWorkers = 0;
+
+    while (finishedWorkers < numWorkers_) {
+        PositionResult result;
+        resultQueue.pop(result);
+        resultQueueDepth_.store(resultQueue.size(), std::memory_order_relaxed);
+
+        if (result.index < 0) {
+            finishedWorkers++;
+            continue;
+        }
+
+        // after a stop the remaining results are drained so the workers can finish
+        if (stop.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        pending[result.index] = result.position;
+
+        for (auto it = pending.begin(); it != pending.end() && it->first == nextIndex; it = pending.erase(it)) {
+            nextIndex++;
+            if (!onPosition(it->first, it->second)) {
+                stop = true;
+                pending.clear();
+                break;
+            }
+        }
+
+        reorderBufferDepth_.store(pending.size(), std::memory_order_relaxed);
+        updateMaxDepth(maxReorderBufferDepth_, pending.size());
+    }
+
+    decoder.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    frameQueueDepth_ = 0;
+    resultQueueDepth_ = 0;
+    reorderBufferDepth_ = 0;
+
+    return nextIndex;
+}
+
+
+/**
+ * @brief Tracks an object with the multithreaded pipeline and saves all positions in frame order.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param fileName The text file the positions are saved to with saveVectorToFile().
+ * @param numWorkers Number of worker threads; 0 picks one based on the number of cores.
+ * @return int The number of frames processed, or -1 on error.
+ */
+int trackObjectPositionsPipelined(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, int numWorkers) {
+    TrackingPipeline pipeline(lower, upper, numWorkers);
+    std::vector<cv::Point2f> positions;
+
+    int frameCount = pipeline.run(video, [&positions](int, const cv::Point2f& position) {
+        positions.push_back(position);
+        return true;
+    });
+
+    if (frameCount < 0) {
+        return -1;
+    }
+
+    std::cout << "Pipeline: " << pipeline.numWorkers() << " workers, max queue depths: frames "
+        << pipeline.maxFrameQueueDepth() << ", results " << pipeline.maxResultQueueDepth()
+        << ", reorder " << pipeline.maxReorderBufferDepth() << std::endl;
+
+    saveVectorToFile(positions, fileName);
+    return frameCount;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <opencv2/opencv.hpp>
+
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov ring buffer). The capacity is rounded up to a power of two.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        cells_.reset(new Cell[size]);
+        mask_ = size - 1;
+        for (std::size_t i = 0; i < size; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+    }
+
+    // append a value, returns false if the queue is full
+    bool tryPush(const T& value) {
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells_[pos & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // take the oldest value, returns false if the queue is empty
+    bool tryPop(T& value) {
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells_[pos & mask_];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->value;
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // append a value, waiting while the queue is full
+    void push(const T& value) {
+        for (int attempt = 0; !tryPush(value); attempt++) {
+            backOff(attempt);
+        }
+    }
+
+    // take the oldest value, waiting while the queue is empty
+    void pop(T& value) {
+        for (int attempt = 0; !tryPop(value); attempt++) {
+            backOff(attempt);
+        }
+    }
+
+    // approximate number of values in the queue, safe to call from any thread
+    std::size_t size() const {
+        std::size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+        std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // spin briefly, then yield, then sleep so idle stages do not burn a core
+    static void backOff(int attempt) {
+        if (attempt < 64) {
+            return;
+        }
+        if (attempt < 256) {
+            std::this_thread::yield();
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> enqueuePos_;
+    alignas(64) std::atomic<std::size_t> dequeuePos_;
+};
+
+
+// Multithreaded ball tracker: a decode thread fills frames from a FramePool and feeds a bounded queue, N worker threads
+// compute the object position of each frame, and the calling thread reorders the results and emits them in frame order.
+class TrackingPipeline {
+public:
+    TrackingPipeline(const cv::Point3f& lower, const cv::Point3f& upper, int numWorkers = 0, std::size_t queueCapacity = 16);
+
+    // run the pipeline over the whole video; onPosition is called in frame order and may return false to stop
+    int run(cv::VideoCapture& video, const std::function<bool(int, const cv::Point2f&)>& onPosition);
+
+    // queue depths, safe to read from another thread while run() is busy
+    std::size_t frameQueueDepth() const { return frameQueueDepth_.load(std::memory_order_relaxed); }
+    std::size_t resultQueueDepth() const { return resultQueueDepth_.load(std::memory_order_relaxed); }
+    std::size_t reorderBufferDepth() const { return reorderBufferDepth_.load(std::memory_order_relaxed); }
+    std::size_t maxFrameQueueDepth() const { return maxFrameQueueDepth_.load(std::memory_order_relaxed); }
+    std::size_t maxResultQueueDepth() const { return maxResultQueueDepth_.load(std::memory_order_relaxed); }
+    std::size_t maxReorderBufferDepth() const { return maxReorderBufferDepth_.load(std::memory_order_relaxed); }
+
+    int numWorkers() const { return numWorkers_; }
+
+private:
+    cv::Point3f lower_;
+    cv::Point3f upper_;
+    int numWorkers_;
+    std::size_t queueCapacity_;
+
+    std::atomic<std::size_t> frameQueueDepth_{ 0 };
+    std::atomic<std::size_t> resultQueueDepth_{ 0 };
+    std::atomic<std::size_t> reorderBufferDepth_{ 0 };
+    std::atomic<std::size_t> maxFrameQueueDepth_{ 0 };
+    std::atomic<std::size_t> maxResultQueueDepth_{ 0 };
+    std::atomic<std::size_t> maxReorderBufferDepth_{ 0 };
+};
+
+
+// track an object with the multithreaded pipeline and save all positions, in frame order, with saveVectorToFile()
+int trackObjectPositionsPipelined(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, int numWorkers = 0);
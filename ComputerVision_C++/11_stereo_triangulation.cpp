@@ -0,0 +1,214 @@
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+#include "11_stereo_triangulation.h"
+
+
+/**
+ * @brief Loads a stereo calibration from a YAML/XML file written by saveStereoCalibration().
+ * @param filename The name of the file.
+ * @param calibration The loaded calibration.
+ * @return true if all parameters were found, false otherwise.
+ */
+bool loadStereoCalibration(const std::string& filename, StereoCalibration& calibration) {
+    cv::FileStorage fs(filename, cv::FileStorage::READ);
+
+    if (!fs.isOpened()) {
+        std::cerr << "Error: Could not open " << filename << " for loading the stereo calibration." << std::endl;
+        return false;
+    }
+
+    cv::Mat K1, k1, K2, k2, R, T;
+    fs["K1"] >> K1;
+    fs["k1"] >> k1;
+    fs["K2"] >> K2;
+    fs["k2"] >> k2;
+    fs["R"] >> R;
+    fs["T"] >> T;
+
+    if (K1.total() != 9 || k1.total() != 5 || K2.total() != 9 || k2.total() != 5 || R.total() != 9 || T.total() != 3) {
+        std::cerr << "Error: " << filename << " does not contain a complete stereo calibration." << std::endl;
+        return false;
+    }
+
+    K1.reshape(1, 3).convertTo(K1, CV_32F);
+    K2.reshape(1, 3).convertTo(K2, CV_32F);
+    R.reshape(1, 3).convertTo(R, CV_32F);
+    k1.reshape(1, 5).convertTo(k1, CV_32F);
+    k2.reshape(1, 5).convertTo(k2, CV_32F);
+    T.reshape(1, 3).convertTo(T, CV_32F);
+
+    calibration.K1 = cv::Matx33f(K1.ptr<float>());
+    calibration.K2 = cv::Matx33f(K2.ptr<float>());
+    calibration.R = cv::Matx33f(R.ptr<float>());
+    calibration.k1 = cv::Vec<float, 5>(k1.ptr<float>());
+    calibration.k2 = cv::Vec<float, 5>(k2.ptr<float>());
+    calibration.T = cv::Vec3f(T.ptr<float>());
+
+    return true;
+}
+
+
+/**
+ * @brief Saves a stereo calibration as YAML/XML (the format is chosen by the file extension).
+ * @param filename The name of the file.
+ * @param calibration The stereo calibration.
+ * @return true if the file was written successfully, false otherwise.
+ */
+bool saveStereoCalibration(const std::string& filename, const StereoCalibration& calibration) {
+    cv::FileStorage fs(filename, cv::FileStorage::WRITE);
+
+    if (!fs.isOpened()) {
+        std::cerr << "Error: Could not open " << filename << " for saving the stereo calibration." << std::endl;
+        return false;
+    }
+
+    fs << "K1" << cv::Mat(calibration.K1);
+    fs << "k1" << cv::Mat(calibration.k1);
+    fs << "K2" << cv::Mat(calibration.K2);
+    fs << "k2" << cv::Mat(calibration.k2);
+    fs << "R" << cv::Mat(calibration.R);
+    fs << "T" << cv::Mat(calibration.T);
+
+    return true;
+}
+
+
+/**
+ * @brief Creates a triangulator for a calibrated stereo pair.
+ *
+ * The points are undistorted to normalized camera coordinates, so the projection matrices are [I | 0] for the
+ * left camera and [R | T] for the right camera.
+ *
+ * @param calibration The stereo calibration.
+ */
+StereoTriangulator::StereoTriangulator(const StereoCalibration& calibration)
+    : calibration_(calibration) {
+    const cv::Matx33f& R = calibration.R;
+    const cv::Vec3f& T = calibration.T;
+
+    P1_ = cv::Matx34f(1, 0, 0, 0,
+                      0, 1, 0, 0,
+                      0, 0, 1, 0);
+    P2_ = cv::Matx34f(R(0, 0), R(0, 1), R(0, 2), T[0],
+                      R(1, 0), R(1, 1), R(1, 2), T[1],
+                      R(2, 0), R(2, 1), R(2, 2), T[2]);
+}
+
+
+/**
+ * @brief Triangulates a batch of synchronized centroid pairs.
+ *
+ * Pairs where the ball was not found in one of the cameras ((-1, -1), as returned by findObjectPosition()) are
+ * skipped and produce NaN points. All remaining pairs are undistorted with one cv::undistortPoints() call per camera
+ * and triangulated with a single cv::triangulatePoints() call.
+ *
+ * @param left The centroids in the left camera, one per frame.
+ * @param right The centroids in the right camera, one per frame.
+ * @param points3D The 3D points in the left camera frame, in the units of T; one per frame.
+ */
+void StereoTriangulator::triangulate(const std::vector<cv::Point2f>& left, const std::vector<cv::Point2f>& right, std::vector<cv::Point3f>& points3D) {
+    CV_Assert(left.size() == right.size());
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    points3D.assign(left.size(), cv::Point3f(nan, nan, nan));
+
+    validIndices_.clear();
+    validLeft_.clear();
+    validRight_.clear();
+    for (std::size_t i = 0; i < left.size(); i++) {
+        if (left[i].x >= 0 && left[i].y >= 0 && right[i].x >= 0 && right[i].y >= 0) {
+            validIndices_.push_back(static_cast<int>(i));
+            validLeft_.push_back(left[i]);
+            validRight_.push_back(right[i]);
+        }
+    }
+
+    if (validIndices_.empty()) {
+        return;
+    }
+
+    cv::undistortPoints(validLeft_, normalizedLeft_, calibration_.K1, calibration_.k1);
+    cv::undistortPoints(validRight_, normalizedRight_, calibration_.K2, calibration_.k2);
+
+    // 4 x N homogeneous points
+    cv::triangulatePoints(P1_, P2_, normalizedLeft_, normalizedRight_, homogeneous_);
+
+    const float* X = homogeneous_.ptr<float>(0);
+    const float* Y = homogeneous_.ptr<float>(1);
+    const float* Z = homogeneous_.ptr<float>(2);
+    const float* W = homogeneous_.ptr<float>(3);
+    for (std::size_t i = 0; i < validIndices_.size(); i++) {
+        if (W[i] != 0.0f) {
+            points3D[validIndices_[i]] = cv::Point3f(X[i] / W[i], Y[i] / W[i], Z[i] / W[i]);
+        }
+    }
+}
+
+
+/**
+ * @brief Creates a trajectory builder that triangulates live position streams in batches.
+ *
+ * @param calibration The stereo calibration.
+ * @param onPoint Called in frame order with the frame index and the 3D point (NaN if the ball was missed).
+ * @param batchSize Number of frame pairs triangulated together; smaller batches lower the latency.
+ */
+StereoTrajectoryBuilder::StereoTrajectoryBuilder(const StereoCalibration& calibration, const std::function<void(int, const cv::Point3f&)>& onPoint, std::size_t batchSize)
+    : triangulator_(calibration), onPoint_(onPoint), batchSize_(std::max<std::size_t>(batchSize, 1)) {
+    frameIndices_.reserve(batchSize_);
+    left_.reserve(batchSize_);
+    right_.reserve(batchSize_);
+}
+
+
+// Adds the centroids of one synchronized frame pair and triangulates when the batch is full
+void StereoTrajectoryBuilder::addFramePair(int frameIndex, const cv::Point2f& left, const cv::Point2f& right) {
+    frameIndices_.push_back(frameIndex);
+    left_.push_back(left);
+    right_.push_back(right);
+
+    if (frameIndices_.size() >= batchSize_) {
+        flush();
+    }
+}
+
+
+// Triangulates and emits the frame pairs collected so far
+void StereoTrajectoryBuilder::flush() {
+    if (frameIndices_.empty()) {
+        return;
+    }
+
+    triangulator_.triangulate(left_, right_, points3D_);
+    for (std::size_t i = 0; i < points3D_.size(); i++) {
+        onPoint_(frameIndices_[i], points3D_[i]);
+    }
+
+    frameIndices_.clear();
+    left_.clear();
+    right_.clear();
+}
+
+
+/**
+ * @brief Triangulates two complete position streams into a 3D trajectory.
+ *
+ * @param left The centroids in the left camera, one per frame.
+ * @param right The centroids in the right camera, one per frame; extra frames of the longer stream are ignored.
+ * @param calibration The stereo calibration.
+ * @return std::vector<cv::Point3f> One 3D point per frame (NaN where the ball was missed in either camera).
+ */
+std::vector<cv::Point3f> triangulateTrajectory(const std::vector<cv::Point2f>& left, const std::vector<cv::Point2f>& right, const StereoCalibration& calibration) {
+    std::size_t numFrames = std::min(left.size(), right.size());
+
+    std::vector<cv::Point2f> synchronizedLeft(left.begin(), left.begin() + numFrames);
+    std::vector<cv::Point2f> synchronizedRight(right.begin(), right.begin() + numFrames);
+
+    StereoTriangulator triangulator(calibration);
+    std::vector<cv::Point3f> points3D;
+    triangulator.triangulate(synchronizedLeft, synchronizedRight, points3D);
+
+    return points3D;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+// Intrinsics of both cameras and the pose of the right camera relative to the left one (as returned by cv::stereoCalibrate)
+struct StereoCalibration {
+    cv::Matx33f K1;
+    cv::Vec<float, 5> k1;
+    cv::Matx33f K2;
+    cv::Vec<float, 5> k2;
+    cv::Matx33f R;
+    cv::Vec3f T;
+};
+
+// Load a stereo calibration from a YAML/XML file with the keys K1, k1, K2, k2, R and T
+bool loadStereoCalibration(const std::string& filename, StereoCalibration& calibration);
+
+// Save a stereo calibration as YAML/XML with the keys K1, k1, K2, k2, R and T
+bool saveStereoCalibration(const std::string& filename, const StereoCalibration& calibration);
+
+
+// Triangulates synchronized 2D centroids of two cameras into 3D points in the left camera frame.
+// Points are undistorted and triangulated in batches, with one OpenCV call per batch instead of one per frame.
+class StereoTriangulator {
+public:
+    explicit StereoTriangulator(const StereoCalibration& calibration);
+
+    // triangulate a batch of centroid pairs; pairs where either centroid is (-1, -1) give NaN points
+    void triangulate(const std::vector<cv::Point2f>& left, const std::vector<cv::Point2f>& right, std::vector<cv::Point3f>& points3D);
+
+private:
+    StereoCalibration calibration_;
+    cv::Matx34f P1_;
+    cv::Matx34f P2_;
+
+    // scratch buffers reused between batches
+    std::vector<int> validIndices_;
+    std::vector<cv::Point2f> validLeft_;
+    std::vector<cv::Point2f> validRight_;
+    std::vector<cv::Point2f> normalizedLeft_;
+    std::vector<cv::Point2f> normalizedRight_;
+    cv::Mat homogeneous_;
+};
+
+
+// Builds a 3D trajectory from two live position streams: pairs are collected per frame and triangulated in batches.
+class StereoTrajectoryBuilder {
+public:
+    StereoTrajectoryBuilder(const StereoCalibration& calibration, const std::function<void(int, const cv::Point3f&)>& onPoint, std::size_t batchSize = 64);
+
+    // add the centroids of one synchronized frame pair; triangulates when a batch is full
+    void addFramePair(int frameIndex, const cv::Point2f& left, const cv::Point2f& right);
+
+    // triangulate and emit the frames collected so far
+    void flush();
+
+private:
+    StereoTriangulator triangulator_;
+    std::function<void(int, const cv::Point3f&)> onPoint_;
+    std::size_t batchSize_;
+
+    std::vector<int> frameIndices_;
+    std::vector<cv::Point2f> left_;
+    std::vector<cv::Point2f> right_;
+    std::vector<cv::Point3f> points3D_;
+};
+
+
+// triangulate two complete position streams (e.g. two ball_positions.txt files) into a 3D trajectory
+std::vector<cv::Point3f> triangulateTrajectory(const std::vector<cv::Point2f>& left, const std::vector<cv::Point2f>& right, const StereoCalibration& calibration);
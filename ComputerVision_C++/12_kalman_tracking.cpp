@@ -0,0 +1,299 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "1_load_images_videos_webcam.h"
+#include "3_resize_crop.h"
+#include "9_pose_tracking.h"
+#include "12_kalman_tracking.h"
+
+
+/**
+ * @brief Creates a Kalman tracker for a 2D position.
+ *
+ * @param processNoise Variance of the unmodelled motion (acceleration for the constant velocity model, jerk for the
+ *                     constant acceleration model) in pixels per frame^2 or frame^3.
+ * @param measurementNoise Variance of a measured position in pixels^2.
+ * @param maxMisses Number of consecutive missed detections the tracker predicts through before the object is lost.
+ */
+template <int StateSize>
+KalmanTracker<StateSize>::KalmanTracker(float processNoise, float measurementNoise, int maxMisses)
+    : processNoise_(processNoise), measurementNoise_(measurementNoise), maxMisses_(std::max(maxMisses, 0)) {
+}
+
+
+template <int StateSize>
+void KalmanTracker<StateSize>::reset() {
+    initialized_ = false;
+    misses_ = 0;
+    x_ = State::zeros();
+    P_ = Covariance::zeros();
+}
+
+
+// state transition for a time step; x and y are independent, each with position, velocity (and acceleration)
+template <int StateSize>
+typename KalmanTracker<StateSize>::Covariance KalmanTracker<StateSize>::transition(float dt) const {
+    Covariance F = Covariance::eye();
+    for (int axis = 0; axis < 2; axis++) {
+        F(axis, 2 + axis) = dt;
+        if (StateSize == 6) {
+            F(axis, 4 + axis) = 0.5f * dt * dt;
+            F(2 + axis, 4 + axis) = dt;
+        }
+    }
+    return F;
+}
+
+
+// piecewise white noise on the highest derivative: Q = G * G^T * q per axis
+template <int StateSize>
+typename KalmanTracker<StateSize>::Covariance KalmanTracker<StateSize>::processNoiseCovariance(float dt) const {
+    const int order = StateSize / 2;
+    const float G[3] = { 0.5f * dt * dt, dt, 1.0f };
+
+    Covariance Q = Covariance::zeros();
+    for (int axis = 0; axis < 2; axis++) {
+        for (int i = 0; i < order; i++) {
+            for (int j = 0; j < order; j++) {
+                Q(2 * i + axis, 2 * j + axis) = G[i] * G[j] * processNoise_;
+            }
+        }
+    }
+    return Q;
+}
+
+
+template <int StateSize>
+void KalmanTracker<StateSize>::predict(float dt) {
+    Covariance F = transition(dt);
+    x_ = F * x_;
+    P_ = F * P_ * F.t() + processNoiseCovariance(dt);
+}
+
+
+// measurement update; H selects the position, so H*P*H^T and P*H^T are read straight from P
+template <int StateSize>
+void KalmanTracker<StateSize>::correct(const cv::Point2f& measurement) {
+    // innovation and its covariance S = H*P*H^T + R
+    float yx = measurement.x - x_(0);
+    float yy = measurement.y - x_(1);
+    float s00 = P_(0, 0) + measurementNoise_;
+    float s01 = P_(0, 1);
+    float s11 = P_(1, 1) + measurementNoise_;
+
+    float det = s00 * s11 - s01 * s01;
+    if (std::abs(det) < 1e-12f) {
+        return;
+    }
+    float i00 = s11 / det;
+    float i01 = -s01 / det;
+    float i11 = s00 / det;
+
+    // K = P*H^T*S^-1
+    cv::Matx<float, StateSize, 2> K;
+    for (int i = 0; i < StateSize; i++) {
+        K(i, 0) = P_(i, 0) * i00 + P_(i, 1) * i01;
+        K(i, 1) = P_(i, 0) * i01 + P_(i, 1) * i11;
+    }
+
+    for (int i = 0; i < StateSize; i++) {
+        x_(i) += K(i, 0) * yx + K(i, 1) * yy;
+    }
+
+    // P = (I - K*H) * P, where K*H only has non-zero columns 0 and 1
+    Covariance updated = P_;
+    for (int i = 0; i < StateSize; i++) {
+        for (int j = 0; j < StateSize; j++) {
+            updated(i, j) -= K(i, 0) * P_(0, j) + K(i, 1) * P_(1, j);
+        }
+    }
+    P_ = updated;
+}
+
+
+/**
+ * @brief Advances the filter by one frame and incorporates the measured position.
+ *
+ * The first valid measurement initializes the position with zero velocity. Missed detections ((-1, -1), as returned
+ * by findObjectPosition()) only advance the prediction, so gaps in the trajectory are filled; after more than
+ * maxMisses consecutive misses the tracker resets.
+ *
+ * @param measurement The measured position, or (-1, -1) if the object was not detected.
+ * @param dt Time since the previous update in frames.
+ * @return cv::Point2f The filtered or predicted position, or (-1, -1) if the object is not tracked.
+ */
+template <int StateSize>
+cv::Point2f KalmanTracker<StateSize>::update(const cv::Point2f& measurement, float dt) {
+    bool detected = measurement.x >= 0 && measurement.y >= 0;
+
+    if (!initialized_) {
+        if (!detected) {
+            return cv::Point2f(-1, -1);
+        }
+
+        x_ = State::zeros();
+        x_(0) = measurement.x;
+        x_(1) = measurement.y;
+
+        // the position is known up to the measurement noise, the derivatives are unknown
+        P_ = Covariance::eye() * 1000.0f;
+        P_(0, 0) = measurementNoise_;
+        P_(1, 1) = measurementNoise_;
+
+        initialized_ = true;
+        misses_ = 0;
+        return measurement;
+    }
+
+    predict(dt);
+
+    if (!detected) {
+        misses_++;
+        if (misses_ > maxMisses_) {
+            reset();
+            return cv::Point2f(-1, -1);
+        }
+        return position();
+    }
+
+    misses_ = 0;
+    correct(measurement);
+    return position();
+}
+
+
+template <int StateSize>
+cv::Point2f KalmanTracker<StateSize>::predictedPosition(float dt) const {
+    if (!initialized_) {
+        return cv::Point2f(-1, -1);
+    }
+
+    State predicted = transition(dt) * x_;
+    return cv::Point2f(predicted(0), predicted(1));
+}
+
+
+/**
+ * @brief Returns the region the object is expected in at the next frame.
+ *
+ * The half size on each axis is half the object extent plus numSigmas times the standard deviation of the
+ * predicted position plus the measurement noise, so the whole object fits even when its center is off by the
+ * expected error, and the window grows automatically while the tracker coasts through missed detections.
+ *
+ * @param frameSize The size of the frame the window is clipped to.
+ * @param objectSize The extent of the object, e.g. the bounding box of the last detection.
+ * @param numSigmas Number of standard deviations covered by the window.
+ * @param minSize Minimum side length of the window in pixels.
+ * @return cv::Rect The search window, or the full frame if the tracker is not initialized.
+ */
+template <int StateSize>
+cv::Rect KalmanTracker<StateSize>::searchWindow(const cv::Size& frameSize, const cv::Size& objectSize, float numSigmas, int minSize) const {
+    const cv::Rect fullFrame(cv::Point(0, 0), frameSize);
+    if (!initialized_) {
+        return fullFrame;
+    }
+
+    Covariance F = transition(1.0f);
+    Covariance predictedP = F * P_ * F.t() + processNoiseCovariance(1.0f);
+    cv::Point2f center = predictedPosition();
+
+    float halfWidth = std::max(objectSize.width / 2.0f + numSigmas * std::sqrt(predictedP(0, 0) + measurementNoise_), minSize / 2.0f);
+    float halfHeight = std::max(objectSize.height / 2.0f + numSigmas * std::sqrt(predictedP(1, 1) + measurementNoise_), minSize / 2.0f);
+
+    cv::Rect window(cvFloor(center.x - halfWidth), cvFloor(center.y - halfHeight), cvCeil(2 * halfWidth), cvCeil(2 * halfHeight));
+    return window & fullFrame;
+}
+
+
+template class KalmanTracker<4>;
+template class KalmanTracker<6>;
+
+
+// Thresholds a region of the frame and returns the centroid of the object and its bounding box in frame coordinates;
+// (-1, -1) and an empty box if no pixel is in range
+static cv::Point2f measureObject(const cv::Mat& bgrFrame, const cv::Rect& region, const cv::Point3f& lower, const cv::Point3f& upper, cv::Rect& boundingBox) {
+    boundingBox = cv::Rect();
+    if (region.empty()) {
+        return cv::Point2f(-1, -1);
+    }
+
+    // no mask: centroid and extent are accumulated while thresholding the region
+    cv::Point2f position = findObjectPositionInColorRange(cropImage(bgrFrame, region), lower, upper, &boundingBox);
+    if (position.x < 0) {
+        return position;
+    }
+
+    boundingBox += region.tl();
+    return position + cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.y));
+}
+
+
+// true if the box reaches a side of the window that is not also a side of the frame, i.e. the object may be cut off
+static bool touchesWindowBorder(const cv::Rect& box, const cv::Rect& window, const cv::Rect& fullFrame) {
+    return (box.x == window.x && window.x > fullFrame.x)
+        || (box.y == window.y && window.y > fullFrame.y)
+        || (box.br().x == window.br().x && window.br().x < fullFrame.br().x)
+        || (box.br().y == window.br().y && window.br().y < fullFrame.br().y);
+}
+
+
+/**
+ * @brief Tracks an object with a constant velocity Kalman filter and saves the filtered positions.
+ *
+ * Each frame only the Kalman search window is thresholded. The window is sized from the bounding box of the
+ * last detection plus the filter uncertainty, so it covers the whole object. If the object is not found in the
+ * window, or it touches the window border and may be cut off (which would pull the centroid towards the
+ * prediction), the full frame is searched before the frame counts as a miss. Missed frames are filled with the
+ * prediction.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param fileName The text file the positions are written to, one "x,y" line per frame.
+ * @param processNoise Variance of the unmodelled acceleration in pixels per frame^2.
+ * @param measurementNoise Variance of a measured position in pixels^2.
+ * @param minWindowSize Minimum side length of the search window in pixels.
+ * @return int The number of frames processed, or -1 on error.
+ */
+int trackObjectPositionsFiltered(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, float processNoise, float measurementNoise, int minWindowSize) {
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source." << std::endl;
+        return -1;
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return -1;
+    }
+
+    ConstantVelocityKalmanTracker tracker(processNoise, measurementNoise);
+    cv::Mat frame;
+    cv::Size objectSize;
+    int frameCount = 0;
+
+    while (readFrame(video, frame)) {
+        const cv::Rect fullFrame(cv::Point(0, 0), frame.size());
+        cv::Rect window = tracker.searchWindow(frame.size(), objectSize, 3.0f, minWindowSize);
+
+        cv::Rect boundingBox;
+        cv::Point2f measurement = measureObject(frame, window, lower, upper, boundingBox);
+
+        bool cutOff = measurement.x >= 0 && touchesWindowBorder(boundingBox, window, fullFrame);
+        if ((measurement.x < 0 || cutOff) && window != fullFrame) {
+            measurement = measureObject(frame, fullFrame, lower, upper, boundingBox);
+        }
+        if (measurement.x >= 0) {
+            objectSize = boundingBox.size();
+        }
+
+        cv::Point2f position = tracker.update(measurement);
+        file << position.x << "," << position.y << "\n";
+        frameCount++;
+    }
+
+    return frameCount;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+
+// Kalman filter for a 2D position with a fixed-size cv::Matx state, so an update never allocates.
+// StateSize 4 is a constant velocity model (x, y, vx, vy), StateSize 6 a constant acceleration model (x, y, vx, vy, ax, ay).
+// Time is measured in frames.
+template <int StateSize>
+class KalmanTracker {
+public:
+    static_assert(StateSize == 4 || StateSize == 6, "KalmanTracker supports 4 (constant velocity) or 6 (constant acceleration) states");
+
+    typedef cv::Matx<float, StateSize, 1> State;
+    typedef cv::Matx<float, StateSize, StateSize> Covariance;
+
+    KalmanTracker(float processNoise = 1.0f, float measurementNoise = 4.0f, int maxMisses = 10);
+
+    // predict, then correct with the measured position; (-1, -1) counts as a missed detection.
+    // Returns the filtered position, the prediction while coasting through misses, or (-1, -1) when the object is lost.
+    cv::Point2f update(const cv::Point2f& measurement, float dt = 1.0f);
+
+    // forget the state; the next measurement initializes the filter again
+    void reset();
+
+    bool isInitialized() const { return initialized_; }
+    int misses() const { return misses_; }
+    cv::Point2f position() const { return cv::Point2f(x_(0), x_(1)); }
+    cv::Point2f velocity() const { return cv::Point2f(x_(2), x_(3)); }
+
+    // position expected dt frames ahead, without changing the state; (-1, -1) if not initialized
+    cv::Point2f predictedPosition(float dt = 1.0f) const;
+
+    // window around the predicted position covering an object of objectSize plus numSigmas standard deviations of the
+    // innovation, clipped to the frame; the full frame if not initialized
+    cv::Rect searchWindow(const cv::Size& frameSize, const cv::Size& objectSize = cv::Size(), float numSigmas = 3.0f, int minSize = 16) const;
+
+    const State& state() const { return x_; }
+    const Covariance& covariance() const { return P_; }
+
+private:
+    void predict(float dt);
+    void correct(const cv::Point2f& measurement);
+    Covariance transition(float dt) const;
+    Covariance processNoiseCovariance(float dt) const;
+
+    float processNoise_;
+    float measurementNoise_;
+    int maxMisses_;
+
+    bool initialized_ = false;
+    int misses_ = 0;
+    State x_;
+    Covariance P_;
+};
+
+typedef KalmanTracker<4> ConstantVelocityKalmanTracker;
+typedef KalmanTracker<6> ConstantAccelerationKalmanTracker;
+
+
+// track an object frame by frame, searching only the Kalman search window, and write the filtered positions to a text file
+int trackObjectPositionsFiltered(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, float processNoise = 1.0f, float measurementNoise = 4.0f, int minWindowSize = 16);
@@ -0,0 +1,237 @@
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "1_load_images_videos_webcam.h"
+#include "9_pose_tracking.h"
+#include "13_multi_object_tracking.h"
+
+
+/**
+ * @brief Creates a tracker for all objects within the given HSV color range.
+ *
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param minArea Blobs with fewer pixels are ignored as noise.
+ * @param maxArea Blobs with more pixels are ignored (e.g. a large same-colored background region).
+ * @param maxDistance Maximum distance in pixels between a predicted track position and a blob for them to match.
+ * @param maxMisses Number of consecutive frames a track may go undetected before it is dropped.
+ */
+MultiObjectTracker::MultiObjectTracker(const cv::Point3f& lower, const cv::Point3f& upper, int minArea, int maxArea, float maxDistance, int maxMisses)
+    : lower_(lower), upper_(upper), minArea_(std::max(minArea, 1)), maxArea_(maxArea), maxDistance_(maxDistance), maxMisses_(std::max(maxMisses, 0)) {
+}
+
+
+void MultiObjectTracker::reset() {
+    trackIds_.clear();
+    trackX_.clear();
+    trackY_.clear();
+    trackVelocityX_.clear();
+    trackVelocityY_.clear();
+    trackMisses_.clear();
+}
+
+
+// label the mask and keep the centroid and area of every blob within the area limits
+void MultiObjectTracker::detectBlobs(const cv::Mat& mask) {
+    int numLabels = cv::connectedComponentsWithStats(mask, labels_, stats_, centroids_, 8, CV_32S);
+
+    blobX_.clear();
+    blobY_.clear();
+    blobArea_.clear();
+
+    // label 0 is the background
+    for (int label = 1; label < numLabels; label++) {
+        int area = stats_.at<int>(label, cv::CC_STAT_AREA);
+        if (area < minArea_ || area > maxArea_) {
+            continue;
+        }
+
+        blobX_.push_back(static_cast<float>(centroids_.at<double>(label, 0)));
+        blobY_.push_back(static_cast<float>(centroids_.at<double>(label, 1)));
+        blobArea_.push_back(area);
+    }
+}
+
+
+// remove a track by moving the last track into its slot
+void MultiObjectTracker::removeTrack(std::size_t index) {
+    std::size_t last = trackIds_.size() - 1;
+
+    trackIds_[index] = trackIds_[last];
+    trackX_[index] = trackX_[last];
+    trackY_[index] = trackY_[last];
+    trackVelocityX_[index] = trackVelocityX_[last];
+    trackVelocityY_[index] = trackVelocityY_[last];
+    trackMisses_[index] = trackMisses_[last];
+
+    trackIds_.pop_back();
+    trackX_.pop_back();
+    trackY_.pop_back();
+    trackVelocityX_.pop_back();
+    trackVelocityY_.pop_back();
+    trackMisses_.pop_back();
+}
+
+
+/**
+ * @brief Matches the blobs of the current frame to the existing tracks.
+ *
+ * Every track is predicted one frame ahead with its velocity. All track/blob pairs closer than maxDistance are
+ * collected and matched greedily from the closest pair on, so each track and each blob is used at most once.
+ * Matched tracks are updated, unmatched blobs start new tracks and tracks missed for more than maxMisses
+ * frames are dropped.
+ */
+void MultiObjectTracker::associate() {
+    const std::size_t numTracks = trackIds_.size();
+    const std::size_t numBlobs = blobX_.size();
+    const float maxDistanceSquared = maxDistance_ * maxDistance_;
+
+    // gated candidate pairs (squared distance, track, blob)
+    candidates_.clear();
+    for (std::size_t t = 0; t < numTracks; t++) {
+        float predictedX = trackX_[t] + trackVelocityX_[t];
+        float predictedY = trackY_[t] + trackVelocityY_[t];
+
+        for (std::size_t b = 0; b < numBlobs; b++) {
+            float dx = blobX_[b] - predictedX;
+            float dy = blobY_[b] - predictedY;
+            float distanceSquared = dx * dx + dy * dy;
+            if (distanceSquared <= maxDistanceSquared) {
+                candidates_.push_back(cv::Vec3f(distanceSquared, static_cast<float>(t), static_cast<float>(b)));
+            }
+        }
+    }
+
+    std::sort(candidates_.begin(), candidates_.end(), [](const cv::Vec3f& a, const cv::Vec3f& b) { return a[0] < b[0]; });
+
+    trackMatched_.assign(numTracks, 0);
+    blobTrack_.assign(numBlobs, -1);
+    for (const cv::Vec3f& candidate : candidates_) {
+        int t = static_cast<int>(candidate[1]);
+        int b = static_cast<int>(candidate[2]);
+        if (trackMatched_[t] || blobTrack_[b] >= 0) {
+            continue;
+        }
+
+        trackMatched_[t] = 1;
+        blobTrack_[b] = t;
+    }
+
+    objects_.clear();
+
+    // update matched tracks
+    for (std::size_t b = 0; b < numBlobs; b++) {
+        int t = blobTrack_[b];
+        if (t < 0) {
+            continue;
+        }
+
+        trackVelocityX_[t] = blobX_[b] - trackX_[t];
+        trackVelocityY_[t] = blobY_[b] - trackY_[t];
+        trackX_[t] = blobX_[b];
+        trackY_[t] = blobY_[b];
+        trackMisses_[t] = 0;
+
+        objects_.push_back(TrackedObject{ trackIds_[t], blobX_[b], blobY_[b], blobArea_[b] });
+    }
+
+    // coast or drop unmatched tracks, iterating backwards so removal does not skip a track
+    for (std::size_t t = numTracks; t-- > 0;) {
+        if (trackMatched_[t]) {
+            continue;
+        }
+
+        trackMisses_[t]++;
+        if (trackMisses_[t] > maxMisses_) {
+            removeTrack(t);
+        }
+        else {
+            trackX_[t] += trackVelocityX_[t];
+            trackY_[t] += trackVelocityY_[t];
+        }
+    }
+
+    // start new tracks
+    for (std::size_t b = 0; b < numBlobs; b++) {
+        if (blobTrack_[b] >= 0) {
+            continue;
+        }
+
+        int id = nextId_++;
+        trackIds_.push_back(id);
+        trackX_.push_back(blobX_[b]);
+        trackY_.push_back(blobY_[b]);
+        trackVelocityX_.push_back(0.0f);
+        trackVelocityY_.push_back(0.0f);
+        trackMisses_.push_back(0);
+
+        objects_.push_back(TrackedObject{ id, blobX_[b], blobY_[b], blobArea_[b] });
+    }
+}
+
+
+/**
+ * @brief Finds all objects in the next frame and assigns them their track ids.
+ *
+ * The blobs are labelled with cv::connectedComponentsWithStats, which needs a mask, so the frame is
+ * thresholded with the vectorized applyColorMaskFused() into a mask buffer that is reused across frames.
+ *
+ * @param bgrFrame The next CV_8UC3 BGR frame.
+ * @return const std::vector<TrackedObject>& The objects found in this frame; valid until the next call.
+ */
+const std::vector<TrackedObject>& MultiObjectTracker::track(const cv::Mat& bgrFrame) {
+    applyColorMaskFused(bgrFrame, lower_, upper_, mask_);
+    return trackMask(mask_);
+}
+
+
+/**
+ * @brief Finds all objects in a binary mask and assigns them their track ids.
+ *
+ * @param mask A CV_8UC1 binary mask, e.g. from applyColorMask().
+ * @return const std::vector<TrackedObject>& The objects found in this frame; valid until the next call.
+ */
+const std::vector<TrackedObject>& MultiObjectTracker::trackMask(const cv::Mat& mask) {
+    detectBlobs(mask);
+    associate();
+    return objects_;
+}
+
+
+/**
+ * @brief Tracks all objects in a color range through a video and saves them to a text file.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param fileName The text file; one "frame,id,x,y,area" line per object and frame.
+ * @param minArea Blobs with fewer pixels are ignored as noise.
+ * @return int The number of frames processed, or -1 on error.
+ */
+int trackMultipleObjectsToFile(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, int minArea) {
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source." << std::endl;
+        return -1;
+    }
+
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return -1;
+    }
+
+    MultiObjectTracker tracker(lower, upper, minArea);
+    cv::Mat frame;
+    int frameCount = 0;
+
+    while (readFrame(video, frame)) {
+        for (const TrackedObject& object : tracker.track(frame)) {
+            file << frameCount << "," << object.id << "," << object.x << "," << object.y << "," << object.area << "\n";
+        }
+        frameCount++;
+    }
+
+    return frameCount;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <climits>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+
+// One object found in a frame: its persistent track id, centroid and area in pixels
+struct TrackedObject {
+    int id;
+    float x;
+    float y;
+    int area;
+};
+
+
+// Tracks many objects of the same color: blobs are labeled with connected components, filtered by area and
+// associated to persistent track ids by gated nearest neighbour matching against the predicted track positions.
+// Tracks are stored as a structure of arrays so association stays cheap with hundreds of objects per frame.
+class MultiObjectTracker {
+public:
+    MultiObjectTracker(const cv::Point3f& lower, const cv::Point3f& upper, int minArea = 50, int maxArea = INT_MAX, float maxDistance = 50.0f, int maxMisses = 5);
+
+    // find the objects in the next BGR frame and return them with their track ids
+    const std::vector<TrackedObject>& track(const cv::Mat& bgrFrame);
+
+    // same as track(), but for an already thresholded binary mask
+    const std::vector<TrackedObject>& trackMask(const cv::Mat& mask);
+
+    // drop all tracks; ids keep increasing so they are never reused
+    void reset();
+
+    std::size_t numTracks() const { return trackIds_.size(); }
+
+private:
+    void detectBlobs(const cv::Mat& mask);
+    void associate();
+    void removeTrack(std::size_t index);
+
+    cv::Point3f lower_;
+    cv::Point3f upper_;
+    int minArea_;
+    int maxArea_;
+    float maxDistance_;
+    int maxMisses_;
+    int nextId_ = 0;
+
+    // tracks (structure of arrays)
+    std::vector<int> trackIds_;
+    std::vector<float> trackX_;
+    std::vector<float> trackY_;
+    std::vector<float> trackVelocityX_;
+    std::vector<float> trackVelocityY_;
+    std::vector<int> trackMisses_;
+
+    // blobs of the current frame (structure of arrays)
+    std::vector<float> blobX_;
+    std::vector<float> blobY_;
+    std::vector<int> blobArea_;
+
+    // scratch buffers reused between frames
+    cv::Mat mask_;
+    cv::Mat labels_;
+    cv::Mat stats_;
+    cv::Mat centroids_;
+    std::vector<cv::Vec3f> candidates_;
+    std::vector<int> blobTrack_;
+    std::vector<char> trackMatched_;
+    std::vector<TrackedObject> objects_;
+};
+
+
+// track all objects in a color range and write one "frame,id,x,y,area" line per object and frame to a text file
+int trackMultipleObjectsToFile(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName, int minArea = 50);
@@ -0,0 +1,458 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <opencv2/core.hpp>
+#include "9_pose_tracking.h"
+#include "14_trajectory_log.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static const char trajectoryLogMagic[4] = { 'T', 'R', 'J', 'L' };
+static const uint32_t trajectoryLogVersion = 1;
+static const uint32_t trajectoryLogHasConfidence = 1;
+
+struct TrajectoryLogHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t blockCapacity;
+};
+
+struct TrajectoryBlockHeader {
+    uint32_t count;
+    uint32_t reserved;
+};
+
+
+// size in bytes of a block with count samples, padded so the next block starts 8 byte aligned
+static std::size_t blockSizeInBytes(std::size_t count, bool withConfidence) {
+    std::size_t size = sizeof(TrajectoryBlockHeader) + count * (sizeof(double) + sizeof(int32_t) + 2 * sizeof(float));
+    if (withConfidence) {
+        size += count * sizeof(float);
+    }
+    return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+
+TrajectoryLogWriter::~TrajectoryLogWriter() {
+    close();
+}
+
+
+/**
+ * @brief Creates a trajectory log, replacing an existing file.
+ *
+ * @param fileName The name of the log file.
+ * @param withConfidence Whether a confidence column is stored.
+ * @param blockCapacity Number of samples buffered per column before a block is written. Large blocks mean few, large
+ *                      writes and fast scans; the buffered block is what a crash can lose.
+ * @param durable If true, the file is flushed after every block, so a crash loses at most the buffered block;
+ *                otherwise it is only flushed by flush() and close() and the stream buffer may be lost as well.
+ * @return true if the file was created, false otherwise.
+ */
+bool TrajectoryLogWriter::open(const std::string& fileName, bool withConfidence, std::size_t blockCapacity, bool durable) {
+    close();
+
+    file_.clear();
+    file_.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return false;
+    }
+
+    fileName_ = fileName;
+    withConfidence_ = withConfidence;
+    durable_ = durable;
+    blockCapacity_ = std::max<std::size_t>(blockCapacity, 1);
+    numWritten_ = 0;
+
+    timestamps_.reserve(blockCapacity_);
+    frameIndices_.reserve(blockCapacity_);
+    x_.reserve(blockCapacity_);
+    y_.reserve(blockCapacity_);
+    if (withConfidence_) {
+        confidences_.reserve(blockCapacity_);
+    }
+
+    TrajectoryLogHeader header;
+    std::memcpy(header.magic, trajectoryLogMagic, sizeof(header.magic));
+    header.version = trajectoryLogVersion;
+    header.flags = withConfidence_ ? trajectoryLogHasConfidence : 0;
+    header.blockCapacity = static_cast<uint32_t>(blockCapacity_);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!file_.good()) {
+        std::cerr << "Error: Could not write to " << fileName_ << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool TrajectoryLogWriter::append(int frameIndex, double timestamp, const cv::Point2f& position, float confidence) {
+    if (!file_.is_open() || !file_.good()) {
+        return false;
+    }
+
+    timestamps_.push_back(timestamp);
+    frameIndices_.push_back(frameIndex);
+    x_.push_back(position.x);
+    y_.push_back(position.y);
+    if (withConfidence_) {
+        confidences_.push_back(confidence);
+    }
+
+    if (frameIndices_.size() >= blockCapacity_) {
+        return writeBlock();
+    }
+    return true;
+}
+
+
+// write the buffered columns as one block with a few large writes; flushed only for durable logs
+bool TrajectoryLogWriter::writeBlock() {
+    if (!file_.is_open() || !file_.good()) {
+        return false;
+    }
+    if (frameIndices_.empty()) {
+        return true;
+    }
+
+    std::size_t count = frameIndices_.size();
+    TrajectoryBlockHeader header = { static_cast<uint32_t>(count), 0 };
+
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(reinterpret_cast<const char*>(timestamps_.data()), count * sizeof(double));
+    file_.write(reinterpret_cast<const char*>(frameIndices_.data()), count * sizeof(int32_t));
+    file_.write(reinterpret_cast<const char*>(x_.data()), count * sizeof(float));
+    file_.write(reinterpret_cast<const char*>(y_.data()), count * sizeof(float));
+    if (withConfidence_) {
+        file_.write(reinterpret_cast<const char*>(confidences_.data()), count * sizeof(float));
+    }
+
+    std::size_t unpadded = sizeof(header) + count * (sizeof(double) + sizeof(int32_t) + 2 * sizeof(float)) + (withConfidence_ ? count * sizeof(float) : 0);
+    static const char padding[8] = {};
+    file_.write(padding, blockSizeInBytes(count, withConfidence_) - unpadded);
+    if (durable_) {
+        file_.flush();
+    }
+
+    if (!file_.good()) {
+        std::cerr << "Error: Could not write to " << fileName_ << "." << std::endl;
+        return false;
+    }
+
+    numWritten_ += count;
+    timestamps_.clear();
+    frameIndices_.clear();
+    x_.clear();
+    y_.clear();
+    confidences_.clear();
+    return true;
+}
+
+
+bool TrajectoryLogWriter::flush() {
+    if (!writeBlock()) {
+        return false;
+    }
+
+    file_.flush();
+    if (!file_.good()) {
+        std::cerr << "Error: Could not write to " << fileName_ << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool TrajectoryLogWriter::close() {
+    if (!file_.is_open()) {
+        return true;
+    }
+
+    bool written = flush();
+    file_.close();
+    if (file_.fail() && written) {
+        std::cerr << "Error: Could not close " << fileName_ << "." << std::endl;
+        written = false;
+    }
+
+    // samples that could not be written are dropped with the file
+    timestamps_.clear();
+    frameIndices_.clear();
+    x_.clear();
+    y_.clear();
+    confidences_.clear();
+    return written;
+}
+
+
+TrajectoryLogReader::~TrajectoryLogReader() {
+    close();
+}
+
+
+/**
+ * @brief Memory maps a trajectory log and indexes its blocks.
+ *
+ * No samples are copied; the columns of every block point into the mapping. A block that extends past the end
+ * of the file (the writer was interrupted) is ignored.
+ *
+ * @param fileName The name of the log file.
+ * @return true if the file is a valid trajectory log, false otherwise.
+ */
+bool TrajectoryLogReader::open(const std::string& fileName) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open " << fileName << " for reading." << std::endl;
+        return false;
+    }
+    fileHandle_ = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        std::cerr << "Error: Could not get the size of " << fileName << "." << std::endl;
+        close();
+        return false;
+    }
+    fileSize_ = static_cast<std::size_t>(size.QuadPart);
+
+    if (fileSize_ > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            mappingHandle_ = mapping;
+            data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    fileDescriptor_ = ::open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor_ < 0) {
+        std::cerr << "Error: Could not open " << fileName << " for reading." << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fileDescriptor_, &status) != 0) {
+        std::cerr << "Error: Could not get the size of " << fileName << "." << std::endl;
+        close();
+        return false;
+    }
+    fileSize_ = static_cast<std::size_t>(status.st_size);
+
+    if (fileSize_ > 0) {
+        void* mapped = mmap(nullptr, fileSize_, PROT_READ, MAP_PRIVATE, fileDescriptor_, 0);
+        if (mapped != MAP_FAILED) {
+            data_ = static_cast<const unsigned char*>(mapped);
+        }
+    }
+#endif
+
+    if (data_ == nullptr || fileSize_ < sizeof(TrajectoryLogHeader)) {
+        std::cerr << "Error: Could not map " << fileName << "." << std::endl;
+        close();
+        return false;
+    }
+
+    TrajectoryLogHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, trajectoryLogMagic, sizeof(header.magic)) != 0 || header.version != trajectoryLogVersion) {
+        std::cerr << "Error: " << fileName << " is not a trajectory log." << std::endl;
+        close();
+        return false;
+    }
+    hasConfidence_ = (header.flags & trajectoryLogHasConfidence) != 0;
+
+    std::size_t offset = sizeof(TrajectoryLogHeader);
+    while (offset + sizeof(TrajectoryBlockHeader) <= fileSize_) {
+        TrajectoryBlockHeader blockHeader;
+        std::memcpy(&blockHeader, data_ + offset, sizeof(blockHeader));
+
+        std::size_t count = blockHeader.count;
+        std::size_t blockSize = blockSizeInBytes(count, hasConfidence_);
+        if (count == 0 || offset + blockSize > fileSize_) {
+            break;
+        }
+
+        const unsigned char* column = data_ + offset + sizeof(TrajectoryBlockHeader);
+        TrajectoryBlock block;
+        block.count = count;
+        block.timestamps = reinterpret_cast<const double*>(column);
+        column += count * sizeof(double);
+        block.frameIndices = reinterpret_cast<const int32_t*>(column);
+        column += count * sizeof(int32_t);
+        block.x = reinterpret_cast<const float*>(column);
+        column += count * sizeof(float);
+        block.y = reinterpret_cast<const float*>(column);
+        column += count * sizeof(float);
+        block.confidences = hasConfidence_ ? reinterpret_cast<const float*>(column) : nullptr;
+
+        blockStarts_.push_back(numSamples_);
+        blocks_.push_back(block);
+        numSamples_ += count;
+        offset += blockSize;
+    }
+
+    return true;
+}
+
+
+void TrajectoryLogReader::close() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    }
+    if (fileHandle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(fileHandle_));
+    }
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<unsigned char*>(data_), fileSize_);
+    }
+    if (fileDescriptor_ >= 0) {
+        ::close(fileDescriptor_);
+    }
+#endif
+
+    data_ = nullptr;
+    fileSize_ = 0;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+    fileDescriptor_ = -1;
+    hasConfidence_ = false;
+    numSamples_ = 0;
+    blocks_.clear();
+    blockStarts_.clear();
+}
+
+
+// block containing a sample; blocks can be partial after a flush, so the start indices are searched
+std::size_t TrajectoryLogReader::findBlock(std::size_t index, std::size_t& offset) const {
+    CV_Assert(index < numSamples_);
+
+    std::size_t block = static_cast<std::size_t>(std::upper_bound(blockStarts_.begin(), blockStarts_.end(), index) - blockStarts_.begin()) - 1;
+    offset = index - blockStarts_[block];
+    return block;
+}
+
+
+int TrajectoryLogReader::frameIndex(std::size_t index) const {
+    std::size_t offset;
+    return blocks_[findBlock(index, offset)].frameIndices[offset];
+}
+
+
+double TrajectoryLogReader::timestamp(std::size_t index) const {
+    std::size_t offset;
+    return blocks_[findBlock(index, offset)].timestamps[offset];
+}
+
+
+cv::Point2f TrajectoryLogReader::position(std::size_t index) const {
+    std::size_t offset;
+    const TrajectoryBlock& block = blocks_[findBlock(index, offset)];
+    return cv::Point2f(block.x[offset], block.y[offset]);
+}
+
+
+float TrajectoryLogReader::confidence(std::size_t index) const {
+    std::size_t offset;
+    const TrajectoryBlock& block = blocks_[findBlock(index, offset)];
+    return block.confidences != nullptr ? block.confidences[offset] : 1.0f;
+}
+
+
+/**
+ * @brief Exports a trajectory log as a CSV file for tools that cannot read the binary format.
+ *
+ * @param logFileName The trajectory log to read.
+ * @param csvFileName The CSV file to write.
+ * @return true if the export succeeded, false otherwise.
+ */
+bool exportTrajectoryLogToCSV(const std::string& logFileName, const std::string& csvFileName) {
+    TrajectoryLogReader reader;
+    if (!reader.open(logFileName)) {
+        return false;
+    }
+
+    std::ofstream file(csvFileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << csvFileName << " for writing." << std::endl;
+        return false;
+    }
+
+    file << (reader.hasConfidence() ? "frame,timestamp,x,y,confidence\n" : "frame,timestamp,x,y\n");
+
+    // lines are formatted into a buffer and written in large chunks
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    char line[128];
+
+    for (std::size_t b = 0; b < reader.numBlocks(); b++) {
+        const TrajectoryBlock& block = reader.block(b);
+
+        for (std::size_t i = 0; i < block.count; i++) {
+            int length;
+            if (block.confidences != nullptr) {
+                length = std::snprintf(line, sizeof(line), "%d,%.3f,%g,%g,%g\n", block.frameIndices[i], block.timestamps[i], block.x[i], block.y[i], block.confidences[i]);
+            }
+            else {
+                length = std::snprintf(line, sizeof(line), "%d,%.3f,%g,%g\n", block.frameIndices[i], block.timestamps[i], block.x[i], block.y[i]);
+            }
+            buffer.append(line, length);
+
+            if (buffer.size() > (1 << 20) - sizeof(line)) {
+                file.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+
+    file.write(buffer.data(), buffer.size());
+    return file.good();
+}
+
+
+/**
+ * @brief Tracks an object frame by frame and appends every sample to a trajectory log.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param fileName The trajectory log to create.
+ * @return int The number of frames processed, or -1 on error (including a failed write of the log).
+ */
+int trackObjectPositionsToLog(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName) {
+    TrajectoryLogWriter writer;
+    if (!writer.open(fileName)) {
+        return -1;
+    }
+
+    // stop at the first failed write instead of tracking the rest of the video for nothing
+    int frameCount = trackObjectPositionsStreaming(video, lower, upper, [&](int frameIndex, const cv::Point2f& position) {
+        return writer.append(frameIndex, video.get(cv::CAP_PROP_POS_MSEC), position);
+    });
+
+    if (!writer.close()) {
+        return -1;
+    }
+    return frameCount;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+
+// Binary columnar trajectory log.
+// Layout: a 16 byte header (magic "TRJL", version, flags, block capacity), followed by blocks. Every block has an
+// 8 byte header (sample count, reserved) and then one column per field: timestamp (double), frame index (int32),
+// x, y and optionally confidence (float). Blocks are padded to 8 bytes so all columns stay aligned when mapped.
+
+
+// Appends samples to a trajectory log; samples are buffered per column and written one full block at a time.
+// The file is only flushed by flush() and close(), or after every block when opened with durable = true.
+class TrajectoryLogWriter {
+public:
+    TrajectoryLogWriter() = default;
+    ~TrajectoryLogWriter();
+
+    TrajectoryLogWriter(const TrajectoryLogWriter&) = delete;
+    TrajectoryLogWriter& operator=(const TrajectoryLogWriter&) = delete;
+
+    // create the file; blockCapacity samples (64K, about 18 min at 60 fps by default) are buffered before each write
+    bool open(const std::string& fileName, bool withConfidence = false, std::size_t blockCapacity = 65536, bool durable = false);
+
+    // buffer one sample; the block is written when it is full. false if the log could not be written
+    bool append(int frameIndex, double timestamp, const cv::Point2f& position, float confidence = 1.0f);
+
+    // write the buffered samples as a (partial) block and flush the file; false if the log could not be written
+    bool flush();
+
+    // flush and close the file; false if the log could not be written completely
+    bool close();
+
+    bool isOpen() const { return file_.is_open(); }
+    std::size_t size() const { return numWritten_ + frameIndices_.size(); }
+
+private:
+    bool writeBlock();
+
+    std::ofstream file_;
+    std::string fileName_;
+    bool withConfidence_ = false;
+    bool durable_ = false;
+    std::size_t blockCapacity_ = 0;
+    std::size_t numWritten_ = 0;
+
+    std::vector<double> timestamps_;
+    std::vector<int32_t> frameIndices_;
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> confidences_;
+};
+
+
+// One block of a mapped trajectory log; the columns point straight into the mapped file
+struct TrajectoryBlock {
+    std::size_t count;
+    const double* timestamps;
+    const int32_t* frameIndices;
+    const float* x;
+    const float* y;
+    const float* confidences;    // nullptr if the log has no confidence column
+};
+
+
+// Reads a trajectory log by memory mapping the file; a truncated last block (e.g. after a crash) is ignored
+class TrajectoryLogReader {
+public:
+    TrajectoryLogReader() = default;
+    ~TrajectoryLogReader();
+
+    TrajectoryLogReader(const TrajectoryLogReader&) = delete;
+    TrajectoryLogReader& operator=(const TrajectoryLogReader&) = delete;
+
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    bool hasConfidence() const { return hasConfidence_; }
+    std::size_t size() const { return numSamples_; }
+
+    // column access per block, for scans over millions of samples
+    std::size_t numBlocks() const { return blocks_.size(); }
+    const TrajectoryBlock& block(std::size_t index) const { return blocks_[index]; }
+
+    // random access to single samples
+    int frameIndex(std::size_t index) const;
+    double timestamp(std::size_t index) const;
+    cv::Point2f position(std::size_t index) const;
+    float confidence(std::size_t index) const;
+
+private:
+    std::size_t findBlock(std::size_t index, std::size_t& offset) const;
+
+    const unsigned char* data_ = nullptr;
+    std::size_t fileSize_ = 0;
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+    int fileDescriptor_ = -1;
+
+    bool hasConfidence_ = false;
+    std::size_t numSamples_ = 0;
+    std::vector<TrajectoryBlock> blocks_;
+    std::vector<std::size_t> blockStarts_;
+};
+
+
+// export a trajectory log as CSV with the header "frame,timestamp,x,y[,confidence]"
+bool exportTrajectoryLogToCSV(const std::string& logFileName, const std::string& csvFileName);
+
+// track an object frame by frame and append frame index, video timestamp (ms) and position to a trajectory log
+int trackObjectPositionsToLog(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName);
@@ -0,0 +1,313 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include "15_telemetry.h"
+
+
+Telemetry& Telemetry::instance() {
+    static Telemetry telemetry;
+    return telemetry;
+}
+
+
+int Telemetry::registerStage(const char* name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (std::size_t i = 0; i < stageNames_.size(); i++) {
+        if (stageNames_[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+
+    stageNames_.push_back(name);
+    return static_cast<int>(stageNames_.size() - 1);
+}
+
+
+// Log-linear histogram buckets: durations below 16 ns have one bucket per nanosecond, every power of two above
+// that is split into 16 buckets, so a bucket is at most 1/16 of its value wide. Durations are clamped to 2^40 ns
+// (about 18 minutes), which gives a fixed 37 * 16 buckets per stage and thread.
+static const int histogramSubBucketBits = 4;
+static const int64_t histogramSubBuckets = int64_t(1) << histogramSubBucketBits;
+static const int histogramMaxBits = 40;
+static const std::size_t histogramNumBuckets = static_cast<std::size_t>((histogramMaxBits - histogramSubBucketBits + 1) * histogramSubBuckets);
+
+static std::size_t histogramBucket(int64_t durationNs) {
+    uint64_t value = static_cast<uint64_t>(std::min(std::max<int64_t>(durationNs, 0), (int64_t(1) << histogramMaxBits) - 1));
+    if (value < static_cast<uint64_t>(histogramSubBuckets)) {
+        return static_cast<std::size_t>(value);
+    }
+
+    int highestBit = 63;
+    while ((value >> highestBit) == 0) {
+        highestBit--;
+    }
+    int shift = highestBit - histogramSubBucketBits;
+    return static_cast<std::size_t>((shift + 1) * histogramSubBuckets + static_cast<int64_t>(value >> shift) - histogramSubBuckets);
+}
+
+// middle of the duration range of a bucket, in nanoseconds
+static double histogramBucketValue(std::size_t bucket) {
+    int64_t index = static_cast<int64_t>(bucket);
+    if (index < histogramSubBuckets) {
+        return static_cast<double>(index);
+    }
+
+    int shift = static_cast<int>(index / histogramSubBuckets) - 1;
+    int64_t lowest = (index % histogramSubBuckets + histogramSubBuckets) << shift;
+    return lowest + ((int64_t(1) << shift) - 1) / 2.0;
+}
+
+
+// the buffer of the calling thread; created on its first event and kept after the thread exits
+Telemetry::ThreadBuffer& Telemetry::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threadBuffers_.emplace_back(new ThreadBuffer());
+        buffer = threadBuffers_.back().get();
+        buffer->threadId = static_cast<int>(threadBuffers_.size());
+    }
+
+    return *buffer;
+}
+
+
+void Telemetry::record(int stage, int64_t startNs, int64_t durationNs) {
+    ThreadBuffer& buffer = threadBuffer();
+
+    // stages can be registered after the thread recorded its first event
+    if (static_cast<std::size_t>(stage) >= buffer.stages.size()) {
+        buffer.stages.resize(stage + 1);
+    }
+
+    StageHistogram& histogram = buffer.stages[stage];
+    if (histogram.buckets.empty()) {
+        histogram.buckets.assign(histogramNumBuckets, 0);
+        histogram.firstStartNs = startNs;
+    }
+    histogram.buckets[histogramBucket(durationNs)]++;
+    histogram.count++;
+    histogram.totalNs += durationNs;
+    histogram.maxNs = std::max(histogram.maxNs, durationNs);
+    histogram.firstStartNs = std::min(histogram.firstStartNs, startNs);
+    histogram.lastEndNs = std::max(histogram.lastEndNs, startNs + durationNs);
+
+    std::size_t traceCapacity = traceCapacity_.load(std::memory_order_relaxed);
+    if (traceCapacity > 0) {
+        if (buffer.trace.size() != traceCapacity) {
+            buffer.trace.assign(traceCapacity, Event());
+            buffer.traceNext = 0;
+            buffer.traceWrapped = false;
+        }
+
+        buffer.trace[buffer.traceNext] = Event{ stage, startNs, durationNs };
+        if (++buffer.traceNext == traceCapacity) {
+            buffer.traceNext = 0;
+            buffer.traceWrapped = true;
+        }
+    }
+}
+
+
+/**
+ * @brief Keeps the most recent events of every thread for the Chrome trace.
+ *
+ * Each thread gets a ring buffer of eventsPerThread events on its next event, so the memory is bounded no matter
+ * how long the run is; older events are overwritten. Call it before the instrumented work starts.
+ *
+ * @param eventsPerThread Number of events kept per thread, 0 to disable the trace.
+ */
+void Telemetry::enableTrace(std::size_t eventsPerThread) {
+    traceCapacity_.store(eventsPerThread, std::memory_order_relaxed);
+}
+
+
+int64_t Telemetry::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void Telemetry::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& buffer : threadBuffers_) {
+        buffer->stages.clear();
+        buffer->traceNext = 0;
+        buffer->traceWrapped = false;
+    }
+}
+
+
+// nearest rank percentile of the merged histogram, as the middle of the bucket it falls into
+static double percentile(const std::vector<uint64_t>& buckets, uint64_t count, double p) {
+    if (count == 0) {
+        return 0.0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(p * (count - 1) + 0.5);
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < buckets.size(); bucket++) {
+        seen += buckets[bucket];
+        if (seen > rank) {
+            return histogramBucketValue(bucket);
+        }
+    }
+    return histogramBucketValue(buckets.size() - 1);
+}
+
+
+/**
+ * @brief Aggregates the histograms of all threads per stage.
+ *
+ * @return std::vector<StageStatistics> One entry per stage with at least one event, in registration order.
+ */
+std::vector<StageStatistics> Telemetry::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<StageStatistics> statistics;
+    std::vector<uint64_t> buckets(histogramNumBuckets);
+
+    for (std::size_t stage = 0; stage < stageNames_.size(); stage++) {
+        std::fill(buckets.begin(), buckets.end(), 0);
+        uint64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        int64_t firstStart = std::numeric_limits<int64_t>::max();
+        int64_t lastEnd = std::numeric_limits<int64_t>::min();
+
+        for (const auto& buffer : threadBuffers_) {
+            if (stage >= buffer->stages.size() || buffer->stages[stage].count == 0) {
+                continue;
+            }
+
+            const StageHistogram& histogram = buffer->stages[stage];
+            for (std::size_t bucket = 0; bucket < histogramNumBuckets; bucket++) {
+                buckets[bucket] += histogram.buckets[bucket];
+            }
+            count += histogram.count;
+            totalNs += histogram.totalNs;
+            maxNs = std::max(maxNs, histogram.maxNs);
+            firstStart = std::min(firstStart, histogram.firstStartNs);
+            lastEnd = std::max(lastEnd, histogram.lastEndNs);
+        }
+
+        if (count == 0) {
+            continue;
+        }
+
+        StageStatistics s;
+        s.name = stageNames_[stage];
+        s.count = static_cast<std::size_t>(count);
+        s.totalMs = totalNs / 1e6;
+        s.meanMs = s.totalMs / count;
+        s.p50Ms = percentile(buckets, count, 0.50) / 1e6;
+        s.p99Ms = percentile(buckets, count, 0.99) / 1e6;
+        s.maxMs = maxNs / 1e6;
+
+        double wallSeconds = (lastEnd - firstStart) / 1e9;
+        s.ratePerSecond = wallSeconds > 0 ? count / wallSeconds : 0.0;
+
+        statistics.push_back(s);
+    }
+
+    return statistics;
+}
+
+
+void Telemetry::printStatistics() const {
+    std::printf("%-28s %10s %10s %10s %10s %12s %10s\n", "stage", "count", "p50 ms", "p99 ms", "max ms", "total ms", "per s");
+    for (const StageStatistics& s : statistics()) {
+        std::printf("%-28s %10zu %10.3f %10.3f %10.3f %12.1f %10.1f\n", s.name.c_str(), s.count, s.p50Ms, s.p99Ms, s.maxMs, s.totalMs, s.ratePerSecond);
+    }
+}
+
+
+/**
+ * @brief Saves the per-stage statistics as JSON.
+ *
+ * @param fileName The name of the JSON file.
+ * @return true if the file was written successfully, false otherwise.
+ */
+bool Telemetry::saveJSON(const std::string& fileName) const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return false;
+    }
+
+    std::vector<StageStatistics> stages = statistics();
+
+    file << "{\n  \"stages\": [\n";
+    for (std::size_t i = 0; i < stages.size(); i++) {
+        const StageStatistics& s = stages[i];
+        file << "    {\"name\": \"" << s.name << "\", \"count\": " << s.count
+            << ", \"mean_ms\": " << s.meanMs << ", \"p50_ms\": " << s.p50Ms << ", \"p99_ms\": " << s.p99Ms
+            << ", \"max_ms\": " << s.maxMs << ", \"total_ms\": " << s.totalMs
+            << ", \"per_second\": " << s.ratePerSecond << "}"
+            << (i + 1 < stages.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+
+    return true;
+}
+
+
+/**
+ * @brief Saves the traced events as a Chrome trace, one track per thread.
+ *
+ * Only the events kept by the ring buffers of enableTrace() are written, i.e. the most recent ones of every
+ * thread. Open the file in chrome://tracing or ui.perfetto.dev to see how the stages of all threads overlap.
+ *
+ * @param fileName The name of the trace file.
+ * @return true if the file was written successfully, false otherwise.
+ */
+bool Telemetry::saveChromeTrace(const std::string& fileName) const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // events of a ring buffer, oldest first
+    auto tracedEvents = [](const ThreadBuffer& buffer) {
+        std::vector<Event> events;
+        if (buffer.traceWrapped) {
+            events.assign(buffer.trace.begin() + buffer.traceNext, buffer.trace.end());
+        }
+        events.insert(events.end(), buffer.trace.begin(), buffer.trace.begin() + buffer.traceNext);
+        return events;
+    };
+
+    if (traceCapacity_.load(std::memory_order_relaxed) == 0) {
+        std::cerr << "Warning: tracing was not enabled, " << fileName << " has no events." << std::endl;
+    }
+
+    // timestamps relative to the first event, in microseconds
+    int64_t origin = std::numeric_limits<int64_t>::max();
+    for (const auto& buffer : threadBuffers_) {
+        for (const Event& event : tracedEvents(*buffer)) {
+            origin = std::min(origin, event.startNs);
+        }
+    }
+
+    file << "{\"traceEvents\": [\n";
+    bool first = true;
+    char line[256];
+    for (const auto& buffer : threadBuffers_) {
+        for (const Event& event : tracedEvents(*buffer)) {
+            std::snprintf(line, sizeof(line), "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                first ? "" : ",\n", stageNames_[event.stage].c_str(), buffer->threadId, (event.startNs - origin) / 1e3, event.durationNs / 1e3);
+            file << line;
+            first = false;
+        }
+    }
+    file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+    return true;
+}
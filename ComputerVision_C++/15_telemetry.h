@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Per-stage timing of the tracking and calibration paths.
+// Build with ENABLE_TELEMETRY defined to record; otherwise TELEMETRY_SCOPE compiles to nothing and costs nothing.
+#define TELEMETRY_CONCAT_INNER(a, b) a##b
+#define TELEMETRY_CONCAT(a, b) TELEMETRY_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_TELEMETRY
+// time the rest of the enclosing scope as the stage "name"; the stage is registered once per call site
+#define TELEMETRY_SCOPE(name) \
+    static const int TELEMETRY_CONCAT(telemetryStage_, __LINE__) = Telemetry::instance().registerStage(name); \
+    ScopedTimer TELEMETRY_CONCAT(telemetryTimer_, __LINE__)(TELEMETRY_CONCAT(telemetryStage_, __LINE__))
+#else
+#define TELEMETRY_SCOPE(name) ((void)0)
+#endif
+
+
+// Latency and throughput of one stage over a run; the percentiles come from a log-linear histogram and are
+// accurate to about 6 %, count, mean, max and total are exact
+struct StageStatistics {
+    std::string name;
+    std::size_t count;
+    double meanMs;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+    double totalMs;
+    double ratePerSecond;    // calls per second of wall time between the first start and the last end
+};
+
+
+// Collects timed events from all threads. Every thread adds its events to its own fixed-size duration histograms
+// (one per stage) without locking, so memory does not grow with the length of the run. Individual events are only
+// kept for the Chrome trace, in a bounded per-thread ring buffer that holds the most recent ones, and only after
+// enableTrace(). The buffers are merged by statistics() and the exporters, which should be called once the
+// instrumented work has stopped.
+class Telemetry {
+public:
+    static Telemetry& instance();
+
+    // id of a stage name, registering it on first use
+    int registerStage(const char* name);
+
+    // add an event to the histogram (and the trace, if enabled) of the calling thread
+    void record(int stage, int64_t startNs, int64_t durationNs);
+
+    // keep the last eventsPerThread events of every thread for saveChromeTrace(); 0 disables the trace (default)
+    void enableTrace(std::size_t eventsPerThread);
+
+    // monotonic time in nanoseconds
+    static int64_t now();
+
+    std::vector<StageStatistics> statistics() const;
+    void printStatistics() const;
+
+    // stage statistics as JSON
+    bool saveJSON(const std::string& fileName) const;
+
+    // the traced events in the Chrome trace event format (chrome://tracing, Perfetto)
+    bool saveChromeTrace(const std::string& fileName) const;
+
+    // drop all recorded events; stage ids stay valid
+    void reset();
+
+private:
+    struct Event {
+        int stage;
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    // durations of one stage in one thread
+    struct StageHistogram {
+        uint64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        int64_t firstStartNs = 0;
+        int64_t lastEndNs = 0;
+        std::vector<uint64_t> buckets;
+    };
+
+    struct ThreadBuffer {
+        int threadId;
+        std::vector<StageHistogram> stages;    // indexed by stage id
+        std::vector<Event> trace;              // ring buffer, empty while tracing is disabled
+        std::size_t traceNext = 0;
+        bool traceWrapped = false;
+    };
+
+    Telemetry() = default;
+    ThreadBuffer& threadBuffer();
+
+    mutable std::mutex mutex_;
+    std::atomic<std::size_t> traceCapacity_{ 0 };
+    std::vector<std::string> stageNames_;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers_;
+};
+
+
+// Records the time between its construction and destruction as one event of a stage
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int stage) : stage_(stage), startNs_(Telemetry::now()) {}
+    ~ScopedTimer() { Telemetry::instance().record(stage_, startNs_, Telemetry::now() - startNs_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int stage_;
+    int64_t startNs_;
+};
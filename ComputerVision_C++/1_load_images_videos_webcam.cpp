@@ -1,8 +1,10 @@
 #include <iostream>
 #include <string>
+#include <atomic>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include "1_load_images_videos_webcam.h"
+#include "15_telemetry.h"
 
 
 // Function to display an image from a file.
@@ -26,9 +28,10 @@ void loadDisplayVideo(const std::string& videoPath) {
     }
 
     // Play the video until it ends or the user presses the "Esc" key.
+    // The frame is reused, so its buffer is only allocated for the first frame.
+    cv::Mat frame;
     while (true) {
-        cv::Mat frame;
-        video >> frame;
+        readFrame(video, frame);
         if (frame.empty()) {
             break;
         }
@@ -51,9 +54,9 @@ void displayWebcam(int cameraId) {
     }
 
     // Display the webcam video until the user presses the "Esc" key.
+    cv::Mat frame;
     while (true) {
-        cv::Mat frame;
-        video >> frame;
+        readFrame(video, frame);
         if (frame.empty()) {
             break;
         }
@@ -66,6 +69,13 @@ void displayWebcam(int cameraId) {
 }
 
 
+// Read (decode) the next frame of a video; the frame buffer is reused when it has the right size and type.
+bool readFrame(cv::VideoCapture& video, cv::Mat& frame) {
+    TELEMETRY_SCOPE("decode");
+    return video.read(frame);
+}
+
+
 /**
  * @brief Loads video frames from a given video file into a vector of cv::Mat objects.
  *
@@ -83,7 +93,7 @@ std::vector<cv::Mat> loadVideoFrames(const std::string& videoPath) {
     std::vector<cv::Mat> frames;
     cv::Mat frame;
 
-    while (video.read(frame)) {
+    while (readFrame(video, frame)) {
         frames.push_back(frame.clone());
     }
 
@@ -102,4 +112,147 @@ void displayVideoFrames(const std::vector<cv::Mat>& frames, const std::string& w
 			break;
 		}
 	}
+}
+
+
+// cv::Mat allocator that forwards to the standard allocator and counts the allocations.
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        if (data == nullptr) {
+            count++;
+        }
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+
+    mutable std::atomic<std::size_t> count{ 0 };
+};
+
+static CountingMatAllocator& countingMatAllocator() {
+    static CountingMatAllocator allocator;
+    return allocator;
+}
+
+
+// Install the counting allocator as the default cv::Mat allocator, remembering the one it replaces.
+MatAllocationCounter::MatAllocationCounter()
+    : previousAllocator_(cv::Mat::getDefaultAllocator()), startCount_(countingMatAllocator().count) {
+    cv::Mat::setDefaultAllocator(&countingMatAllocator());
+}
+
+MatAllocationCounter::~MatAllocationCounter() {
+    cv::Mat::setDefaultAllocator(previousAllocator_);
+}
+
+std::size_t MatAllocationCounter::count() const {
+    return countingMatAllocator().count - startCount_;
+}
+
+
+/**
+ * @brief Creates a pool of frames that are all allocated up front.
+ *
+ * @param capacity The number of frames in the pool, i.e. the maximum number of frames in flight.
+ * @param size The frame size of the stream.
+ * @param type The frame type of the stream, e.g. CV_8UC3 for decoded frames or CV_8UC1 for masks.
+ */
+FramePool::FramePool(std::size_t capacity, const cv::Size& size, int type)
+    : buffers_(capacity), bufferData_(capacity), inUse_(capacity, 0), freeRing_(capacity), freeCount_(capacity) {
+    for (std::size_t i = 0; i < capacity; i++) {
+        buffers_[i].create(size, type);
+        bufferData_[i] = buffers_[i].datastart;
+        freeRing_[i] = i;
+    }
+    allocations_ = capacity;
+}
+
+
+/**
+ * @brief Borrows a free slot, blocking until another stage releases one if the pool is exhausted.
+ *
+ * @return std::size_t The borrowed slot; its frame is accessed with frame() until the slot is released.
+ */
+std::size_t FramePool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    frameReleased_.wait(lock, [this] { return freeCount_ > 0; });
+
+    std::size_t slot = freeRing_[freeHead_];
+    freeHead_ = (freeHead_ + 1) % freeRing_.size();
+    freeCount_--;
+    inUse_[slot] = 1;
+    return slot;
+}
+
+
+/**
+ * @brief Borrows a free slot without blocking.
+ *
+ * @param slot The borrowed slot, if there was a free one.
+ * @return bool False if all slots are in use.
+ */
+bool FramePool::tryAcquire(std::size_t& slot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (freeCount_ == 0) {
+        return false;
+    }
+
+    slot = freeRing_[freeHead_];
+    freeHead_ = (freeHead_ + 1) % freeRing_.size();
+    freeCount_--;
+    inUse_[slot] = 1;
+    return true;
+}
+
+
+/**
+ * @brief Returns a borrowed slot to the pool.
+ *
+ * A slot that does not belong to the pool or is not borrowed is rejected with an error, so a double release
+ * can never hand the same buffer to two borrowers.
+ *
+ * @param slot A slot obtained from acquire() or tryAcquire().
+ */
+void FramePool::release(std::size_t slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (slot >= buffers_.size() || !inUse_[slot]) {
+            std::cerr << "Error: FramePool slot " << slot << " is not borrowed from this pool." << std::endl;
+            return;
+        }
+
+        // the borrower reallocated the frame, e.g. because the stream changed its resolution; a frame emptied by a
+        // failed read is not a new buffer, the next successful read into it is counted instead
+        if (!buffers_[slot].empty() && buffers_[slot].datastart != bufferData_[slot]) {
+            bufferData_[slot] = buffers_[slot].datastart;
+            allocations_++;
+        }
+
+        inUse_[slot] = 0;
+        freeRing_[(freeHead_ + freeCount_) % freeRing_.size()] = slot;
+        freeCount_++;
+    }
+    frameReleased_.notify_one();
+}
+
+
+// Number of frames that can currently be borrowed
+std::size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return freeCount_;
+}
+
+
+// Buffers allocated for the pool, including reallocations of borrowed frames
+std::size_t FramePool::allocations() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocations_;
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <mutex>
+#include <condition_variable>
 #include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
 
 
 // Display an image from a file.
@@ -13,8 +16,65 @@ void loadDisplayVideo(const std::string& videoPath);
 // Display a video from a webcam.
 void displayWebcam(int cameraId);
 
+// Read (decode) the next frame of a video into a reused buffer; timed as the "decode" stage when telemetry is enabled.
+bool readFrame(cv::VideoCapture& video, cv::Mat& frame);
+
 // Load all frames of a video from a file into a vector of cv::Mat.
 std::vector<cv::Mat> loadVideoFrames(const std::string& videoPath);
 
 // display video frames
 void displayVideoFrames(const std::vector<cv::Mat>& frames, const std::string& windowName = "Video");
+
+// Counts the cv::Mat buffer allocations during its lifetime, to verify allocation-free steady state processing.
+// Installs a counting default allocator on construction and restores the previous one on destruction.
+class MatAllocationCounter {
+public:
+    MatAllocationCounter();
+    ~MatAllocationCounter();
+
+    MatAllocationCounter(const MatAllocationCounter&) = delete;
+    MatAllocationCounter& operator=(const MatAllocationCounter&) = delete;
+
+    // number of cv::Mat buffer allocations since construction
+    std::size_t count() const;
+
+private:
+    cv::MatAllocator* previousAllocator_;
+    std::size_t startCount_;
+};
+
+// Fixed-capacity ring of preallocated frames of one size and type. Stages borrow a slot with acquire(), fill its
+// frame in place (e.g. video.read(pool.frame(slot))) and hand the slot back with release(), so no buffer is allocated per frame.
+class FramePool {
+public:
+    FramePool(std::size_t capacity, const cv::Size& size, int type);
+
+    // borrow a free slot, blocking until one is released if all are in use
+    std::size_t acquire();
+
+    // borrow a free slot if there is one
+    bool tryAcquire(std::size_t& slot);
+
+    // return a slot obtained from acquire() or tryAcquire(); invalid slots and double releases are rejected
+    void release(std::size_t slot);
+
+    // the frame of a slot; only valid while the slot is borrowed
+    cv::Mat& frame(std::size_t slot) { return buffers_[slot]; }
+
+    std::size_t capacity() const { return buffers_.size(); }
+    std::size_t available() const;
+
+    // buffers allocated for the pool, including reallocations when a borrowed frame changed its size or type
+    std::size_t allocations() const;
+
+private:
+    std::vector<cv::Mat> buffers_;
+    std::vector<const uchar*> bufferData_;
+    std::vector<char> inUse_;
+    std::vector<std::size_t> freeRing_;
+    std::size_t freeHead_ = 0;
+    std::size_t freeCount_ = 0;
+    std::size_t allocations_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable frameReleased_;
+};
\ No newline at end of file
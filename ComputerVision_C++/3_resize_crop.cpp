@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <cmath>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
@@ -15,7 +16,7 @@ cv::Mat resizeImage(const cv::Mat& inputImage, const cv::Size& size) {
 // sclae image
 cv::Mat scaleImage(const cv::Mat& inputImage, double scaleX, double scaleY) {
 	cv::Mat outputImage;
-	cv::resize(inputImage, outputImage, cv::Size(), scaleX, scaleX);
+	cv::resize(inputImage, outputImage, cv::Size(), scaleX, scaleY);
 	return outputImage;
 }
 
@@ -27,3 +28,104 @@ cv::Mat cropImage(const cv::Mat& inputImage, const cv::Rect& rect) {
 	return outputImage;
 }
 
+
+// Start a new frame; the frame is shared, not copied
+void ImagePyramid::setFrame(const cv::Mat& frame) {
+	frame_ = frame;
+	levelsComputed_ = 0;
+	for (Level& level : levels_) {
+		level.valid = false;
+	}
+}
+
+
+// Size of the level at a scale, at least one pixel
+cv::Size ImagePyramid::levelSize(double scale) const {
+	return cv::Size(std::max(1, cvRound(frame_.cols * scale)), std::max(1, cvRound(frame_.rows * scale)));
+}
+
+
+// Existing entry for a scale or a new, invalid one; scales are compared with a small tolerance
+ImagePyramid::Level& ImagePyramid::findLevel(double scale, bool gray) {
+	for (Level& level : levels_) {
+		if (level.gray == gray && std::abs(level.scale - scale) < 1e-9) {
+			return level;
+		}
+	}
+
+	levels_.push_back(Level{ scale, gray, false, cv::Mat() });
+	return levels_.back();
+}
+
+
+/**
+ * @brief Returns the frame at a reduced scale, computing it only on first use in the current frame.
+ *
+ * The level is resized with cv::INTER_AREA from a parent chosen from the scale alone: the level at twice the
+ * scale if that is below 1, otherwise the full frame. The parent is built first if needed, so the result does
+ * not depend on which levels were requested before, and e.g. the quarter scale level leaves the half scale
+ * level behind for a later request.
+ *
+ * @param scale The scale relative to the full frame, 0 < scale <= 1.
+ * @return const cv::Mat& The level; valid until the next setFrame() call.
+ */
+const cv::Mat& ImagePyramid::level(double scale) {
+	CV_Assert(scale > 0.0 && scale <= 1.0 && !frame_.empty());
+
+	if (scale == 1.0) {
+		return frame_;
+	}
+
+	Level& target = findLevel(scale, false);
+	if (target.valid) {
+		return target.image;
+	}
+
+	// fixed parent: the level at twice the scale, or the frame; levels_ is a deque, so target stays valid
+	const cv::Mat& source = 2.0 * scale < 1.0 ? level(2.0 * scale) : frame_;
+
+	cv::resize(source, target.image, levelSize(scale), 0, 0, cv::INTER_AREA);
+	target.valid = true;
+	levelsComputed_++;
+	return target.image;
+}
+
+
+/**
+ * @brief Returns the grayscale version of a level, computing it only on first use in the current frame.
+ *
+ * @param scale The scale relative to the full frame, 0 < scale <= 1.
+ * @return const cv::Mat& The grayscale level (the level itself if the frame is single channel).
+ */
+const cv::Mat& ImagePyramid::grayLevel(double scale) {
+	const cv::Mat& color = level(scale);
+	if (color.channels() == 1) {
+		return color;
+	}
+
+	Level& target = findLevel(scale, true);
+	if (!target.valid) {
+		cv::cvtColor(color, target.image, color.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+		target.valid = true;
+		levelsComputed_++;
+	}
+	return target.image;
+}
+
+
+// Full frame -> level coordinates, using the real size ratio of the level
+cv::Point2f ImagePyramid::toLevel(const cv::Point2f& point, double scale) const {
+	cv::Size size = levelSize(scale);
+	float sx = static_cast<float>(size.width) / frame_.cols;
+	float sy = static_cast<float>(size.height) / frame_.rows;
+	return cv::Point2f((point.x + 0.5f) * sx - 0.5f, (point.y + 0.5f) * sy - 0.5f);
+}
+
+
+// Level -> full frame coordinates
+cv::Point2f ImagePyramid::fromLevel(const cv::Point2f& point, double scale) const {
+	cv::Size size = levelSize(scale);
+	float sx = static_cast<float>(size.width) / frame_.cols;
+	float sy = static_cast<float>(size.height) / frame_.rows;
+	return cv::Point2f((point.x + 0.5f) / sx - 0.5f, (point.y + 0.5f) / sy - 0.5f);
+}
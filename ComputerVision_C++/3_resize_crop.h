@@ -1,4 +1,5 @@
 #pragma once
+#include <deque>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -9,4 +10,51 @@ cv::Mat resizeImage(const cv::Mat& inputImage, const cv::Size& size);
 cv::Mat scaleImage(const cv::Mat& inputImage, double scaleX, double scaleY);
 
 // crop
-cv::Mat cropImage(const cv::Mat& inputImage, const cv::Rect& rect);
\ No newline at end of file
+cv::Mat cropImage(const cv::Mat& inputImage, const cv::Rect& rect);
+
+
+// Lazily built multi-resolution pyramid of one frame. Every level (any scale, not only powers of two) is computed
+// at most once per frame, from the level at twice its scale (or the frame), so a level is the same whatever was
+// requested before it. Used by the coarse-to-fine corner search, where a retry at twice the scale reuses the
+// parent level of the first attempt. Not thread-safe; fill it from one thread per frame.
+class ImagePyramid {
+public:
+	ImagePyramid() = default;
+	explicit ImagePyramid(const cv::Mat& frame) { setFrame(frame); }
+
+	// start a new frame (shared, not copied); the levels of the previous frame are invalidated but their buffers are reused
+	void setFrame(const cv::Mat& frame);
+
+	// the frame scaled by 0 < scale <= 1; scale 1 is the frame itself
+	const cv::Mat& level(double scale);
+
+	// the frame reduced by an integer factor, e.g. 2 for half the width and height
+	const cv::Mat& levelForFactor(int factor) { return level(1.0 / factor); }
+
+	// grayscale version of a level, also computed at most once per frame
+	const cv::Mat& grayLevel(double scale);
+
+	// map pixel coordinates between the full frame and a level (pixel centers are kept aligned)
+	cv::Point2f toLevel(const cv::Point2f& point, double scale) const;
+	cv::Point2f fromLevel(const cv::Point2f& point, double scale) const;
+
+	const cv::Mat& frame() const { return frame_; }
+
+	// number of levels computed for the current frame, to check that consumers share them
+	int levelsComputed() const { return levelsComputed_; }
+
+private:
+	struct Level {
+		double scale;
+		bool gray;
+		bool valid;
+		cv::Mat image;
+	};
+
+	Level& findLevel(double scale, bool gray);
+	cv::Size levelSize(double scale) const;
+
+	cv::Mat frame_;
+	std::deque<Level> levels_;    // a deque keeps references to levels valid while new levels are added
+	int levelsComputed_ = 0;
+};
\ No newline at end of file
@@ -29,8 +29,11 @@ cv::Mat createImage(int width, int height, cv::Scalar color) {
  * @return The output image with the line drawn.
  */
 cv::Mat drawLineOnImage(cv::Mat& inputImage, cv::Point start, cv::Point end, cv::Scalar color, int thickness) {
+    Overlay overlay;
+    overlay.addLine(start, end, color, thickness);
+
     cv::Mat outputImage = inputImage.clone();
-    cv::line(outputImage, start, end, color, thickness);
+    overlay.render(outputImage);
     return outputImage;
 }
 
@@ -45,8 +48,11 @@ cv::Mat drawLineOnImage(cv::Mat& inputImage, cv::Point start, cv::Point end, cv:
  * @return The output image with the rectangle drawn.
  */
 cv::Mat drawRectangleOnImage(cv::Mat& inputImage, cv::Point topLeft, cv::Point bottomRight, cv::Scalar color, int thickness) {
+    Overlay overlay;
+    overlay.addRectangle(topLeft, bottomRight, color, thickness);
+
     cv::Mat outputImage = inputImage.clone();
-    cv::rectangle(outputImage, topLeft, bottomRight, color, thickness);
+    overlay.render(outputImage);
     return outputImage;
 }
 
@@ -61,8 +67,11 @@ cv::Mat drawRectangleOnImage(cv::Mat& inputImage, cv::Point topLeft, cv::Point b
  * @return The output image with the circle drawn.
  */
 cv::Mat drawCircleOnImage(cv::Mat& inputImage, cv::Point center, int radius, cv::Scalar color, int thickness) {
+    Overlay overlay;
+    overlay.addCircle(center, radius, color, thickness);
+
     cv::Mat outputImage = inputImage.clone();
-    cv::circle(outputImage, center, radius, color, thickness);
+    overlay.render(outputImage);
     return outputImage;
 }
 
@@ -79,7 +88,122 @@ cv::Mat drawCircleOnImage(cv::Mat& inputImage, cv::Point center, int radius, cv:
  * @return The output image with the text added.
  */
 cv::Mat drawTextOnImage(cv::Mat& inputImage, const std::string& text, const cv::Point& origin, int fontFace, double fontScale, const cv::Scalar& color, int thickness) {
+    Overlay overlay;
+    overlay.addText(text, origin, fontFace, fontScale, color, thickness);
+
     cv::Mat outputImage = inputImage.clone();
-    cv::putText(outputImage, text, origin, fontFace, fontScale, color, thickness);
+    overlay.render(outputImage);
     return outputImage;
 }
+
+
+// Records a line
+void Overlay::addLine(cv::Point start, cv::Point end, cv::Scalar color, int thickness) {
+    Command command;
+    command.type = CommandType::Line;
+    command.p1 = start;
+    command.p2 = end;
+    command.color = color;
+    command.thickness = thickness;
+    commands_.push_back(command);
+}
+
+// Records a rectangle
+void Overlay::addRectangle(cv::Point topLeft, cv::Point bottomRight, cv::Scalar color, int thickness) {
+    Command command;
+    command.type = CommandType::Rectangle;
+    command.p1 = topLeft;
+    command.p2 = bottomRight;
+    command.color = color;
+    command.thickness = thickness;
+    commands_.push_back(command);
+}
+
+// Records a circle
+void Overlay::addCircle(cv::Point center, int radius, cv::Scalar color, int thickness) {
+    Command command;
+    command.type = CommandType::Circle;
+    command.p1 = center;
+    command.radius = radius;
+    command.color = color;
+    command.thickness = thickness;
+    commands_.push_back(command);
+}
+
+// Records a text label
+void Overlay::addText(const std::string& text, const cv::Point& origin, int fontFace, double fontScale, const cv::Scalar& color, int thickness) {
+    Command command;
+    command.type = CommandType::Text;
+    command.p1 = origin;
+    command.fontFace = fontFace;
+    command.fontScale = fontScale;
+    command.color = color;
+    command.thickness = thickness;
+    command.dataIndex = texts_.size();
+    texts_.push_back(text);
+    commands_.push_back(command);
+}
+
+// Records a polyline, e.g. a trajectory; the points are copied into a shared buffer
+void Overlay::addPolyline(const std::vector<cv::Point>& points, bool closed, cv::Scalar color, int thickness) {
+    Command command;
+    command.type = CommandType::Polyline;
+    command.closed = closed;
+    command.color = color;
+    command.thickness = thickness;
+    command.dataIndex = points_.size();
+    command.dataCount = points.size();
+    points_.insert(points_.end(), points.begin(), points.end());
+    commands_.push_back(command);
+}
+
+// Removes all commands but keeps the allocated storage
+void Overlay::clear() {
+    commands_.clear();
+    texts_.clear();
+    points_.clear();
+}
+
+
+/**
+ * Draws all recorded commands onto the target image in the order they were added.
+ *
+ * @param target The image to draw on; it is modified in place.
+ */
+void Overlay::render(cv::Mat& target) const {
+    for (const Command& command : commands_) {
+        switch (command.type) {
+        case CommandType::Line:
+            cv::line(target, command.p1, command.p2, command.color, command.thickness);
+            break;
+        case CommandType::Rectangle:
+            cv::rectangle(target, command.p1, command.p2, command.color, command.thickness);
+            break;
+        case CommandType::Circle:
+            cv::circle(target, command.p1, command.radius, command.color, command.thickness);
+            break;
+        case CommandType::Text:
+            cv::putText(target, texts_[command.dataIndex], command.p1, command.fontFace, command.fontScale, command.color, command.thickness);
+            break;
+        case CommandType::Polyline:
+            if (command.dataCount > 0) {
+                const cv::Point* points = &points_[command.dataIndex];
+                int count = static_cast<int>(command.dataCount);
+                cv::polylines(target, &points, &count, 1, command.closed, command.color, command.thickness);
+            }
+            break;
+        }
+    }
+}
+
+
+/**
+ * Copies the base image into a reusable canvas and draws all recorded commands onto the canvas.
+ *
+ * @param base The image to draw over; it is not modified.
+ * @param canvas The output image; its buffer is reused when it already has the size and type of base.
+ */
+void Overlay::renderOnto(const cv::Mat& base, cv::Mat& canvas) const {
+    base.copyTo(canvas);
+    render(canvas);
+}
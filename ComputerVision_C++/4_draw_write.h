@@ -1,4 +1,6 @@
 #pragma once
+#include <string>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -16,3 +18,45 @@ cv::Mat drawCircleOnImage(cv::Mat& inputImage, cv::Point center, int radius, cv:
 
 // Add text to the input image
 cv::Mat drawTextOnImage(cv::Mat& inputImage, const std::string& text, const cv::Point& origin, int fontFace, double fontScale, const cv::Scalar& color, int thickness);
+
+// Records draw commands and renders them all in one pass onto a frame, without copying it.
+// Useful for per-frame HUDs (trajectories, boxes, labels) where the single-shot functions above would clone the frame per shape.
+class Overlay {
+public:
+    void addLine(cv::Point start, cv::Point end, cv::Scalar color, int thickness);
+    void addRectangle(cv::Point topLeft, cv::Point bottomRight, cv::Scalar color, int thickness);
+    void addCircle(cv::Point center, int radius, cv::Scalar color, int thickness);
+    void addText(const std::string& text, const cv::Point& origin, int fontFace, double fontScale, const cv::Scalar& color, int thickness);
+    void addPolyline(const std::vector<cv::Point>& points, bool closed, cv::Scalar color, int thickness);
+
+    // remove all commands but keep the allocated storage for the next frame
+    void clear();
+    std::size_t size() const { return commands_.size(); }
+
+    // draw all commands onto the target image in place
+    void render(cv::Mat& target) const;
+
+    // copy base into a reusable canvas (allocated only when the size or type changes) and draw onto the canvas
+    void renderOnto(const cv::Mat& base, cv::Mat& canvas) const;
+
+private:
+    enum class CommandType { Line, Rectangle, Circle, Text, Polyline };
+
+    struct Command {
+        CommandType type;
+        cv::Point p1;
+        cv::Point p2;
+        int radius = 0;
+        cv::Scalar color;
+        int thickness = 1;
+        int fontFace = 0;
+        double fontScale = 1.0;
+        bool closed = false;
+        std::size_t dataIndex = 0;  // index into texts_ for Text, offset into points_ for Polyline
+        std::size_t dataCount = 0;  // number of points for Polyline
+    };
+
+    std::vector<Command> commands_;
+    std::vector<std::string> texts_;
+    std::vector<cv::Point> points_;
+};
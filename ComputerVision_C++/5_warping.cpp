@@ -1,9 +1,11 @@
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include "5_warping.h"
+#include "7_shape_contour_detection.h"
 
 /**
  * Warps an input image using the provided source points and destination dimensions.
@@ -32,3 +34,194 @@ cv::Mat warpImage(const cv::Mat& inputImage, const std::vector<cv::Point2f>& sou
 
     return warpedImage;
 }
+
+
+/**
+ * @brief Creates a quad warper.
+ *
+ * @param maxCacheEntries Maximum number of cached remap tables; the least recently used ones are dropped.
+ */
+QuadWarper::QuadWarper(std::size_t maxCacheEntries)
+    : maxCacheEntries_(std::max<std::size_t>(maxCacheEntries, 1)) {
+}
+
+
+void QuadWarper::clearCache() {
+    cache_.clear();
+    usage_.clear();
+}
+
+
+// Corners are quantized to 1/32 pixel (cv::INTER_TAB_SIZE), the sub-pixel precision of the CV_16SC2 remap tables
+QuadWarper::WarpKey QuadWarper::makeKey(const std::vector<cv::Point2f>& quad, const cv::Size& outputSize) {
+    const float scale = static_cast<float>(cv::INTER_TAB_SIZE);
+
+    WarpKey key;
+    key.reserve(10);
+    for (const cv::Point2f& corner : quad) {
+        key.push_back(cvRound(corner.x * scale));
+        key.push_back(cvRound(corner.y * scale));
+    }
+    key.push_back(outputSize.width);
+    key.push_back(outputSize.height);
+    return key;
+}
+
+
+// Remap tables of a perspective warp: every output pixel maps to the source point given by the inverse homography
+void QuadWarper::buildMaps(const std::vector<cv::Point2f>& quad, const cv::Size& outputSize, CachedWarp& warp) {
+    const float width = static_cast<float>(outputSize.width);
+    const float height = static_cast<float>(outputSize.height);
+    std::vector<cv::Point2f> destinationPoints = { cv::Point2f(0.0f, 0.0f), cv::Point2f(width, 0.0f), cv::Point2f(0.0f, height), cv::Point2f(width, height) };
+
+    // output -> source, so no inversion is needed
+    cv::Matx33d H = cv::getPerspectiveTransform(destinationPoints, quad);
+
+    cv::Mat map(outputSize, CV_32FC2);
+    for (int y = 0; y < outputSize.height; y++) {
+        cv::Point2f* row = map.ptr<cv::Point2f>(y);
+        double X = H(0, 1) * y + H(0, 2);
+        double Y = H(1, 1) * y + H(1, 2);
+        double W = H(2, 1) * y + H(2, 2);
+
+        for (int x = 0; x < outputSize.width; x++) {
+            double w = W + H(2, 0) * x;
+            w = w != 0.0 ? 1.0 / w : 0.0;
+            row[x] = cv::Point2f(static_cast<float>((X + H(0, 0) * x) * w), static_cast<float>((Y + H(1, 0) * x) * w));
+        }
+    }
+
+    cv::convertMaps(map, cv::Mat(), warp.map1, warp.map2, CV_16SC2);
+}
+
+
+// drop the least recently used remap tables until the cache fits
+void QuadWarper::evict() {
+    while (cache_.size() > maxCacheEntries_) {
+        cache_.erase(usage_.back());
+        usage_.pop_back();
+    }
+}
+
+
+void QuadWarper::warp(const cv::Mat& inputImage, const std::vector<std::vector<cv::Point2f>>& quads, const cv::Size& outputSize, std::vector<cv::Mat>& outputs) {
+    warp(inputImage, quads, std::vector<cv::Size>(quads.size(), outputSize), outputs);
+}
+
+
+/**
+ * @brief Warps many quads of one image in parallel.
+ *
+ * The cache is looked up for every quad first; the remap tables of new quads are then built in parallel and
+ * finally all quads are remapped in parallel, each into its own preallocated output.
+ *
+ * @param inputImage The input image.
+ * @param quads The source quads, 4 points each in the order top-left, top-right, bottom-left, bottom-right.
+ * @param outputSizes The size of the warped image of every quad.
+ * @param outputs The warped images; resized to the number of quads and reused when they already have the right size.
+ */
+void QuadWarper::warp(const cv::Mat& inputImage, const std::vector<std::vector<cv::Point2f>>& quads, const std::vector<cv::Size>& outputSizes, std::vector<cv::Mat>& outputs) {
+    CV_Assert(quads.size() == outputSizes.size());
+
+    const int numQuads = static_cast<int>(quads.size());
+    outputs.resize(numQuads);
+    batch_.assign(numQuads, nullptr);
+
+    // look up the cached tables; new entries are only created here, so the parallel stages never modify the map.
+    // A quad that appears twice in the batch shares one entry.
+    std::vector<int> misses;
+    for (int i = 0; i < numQuads; i++) {
+        CV_Assert(quads[i].size() == 4);
+
+        auto inserted = cache_.emplace(makeKey(quads[i], outputSizes[i]), CachedWarp());
+        CachedWarp& cached = inserted.first->second;
+        if (inserted.second) {
+            usage_.push_front(inserted.first->first);
+            cached.usage = usage_.begin();
+            misses.push_back(i);
+            cacheMisses_++;
+        }
+        else {
+            usage_.splice(usage_.begin(), usage_, cached.usage);
+            cacheHits_++;
+        }
+
+        batch_[i] = &cached;
+    }
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(misses.size())), [&](const cv::Range& range) {
+        for (int m = range.start; m < range.end; m++) {
+            int i = misses[m];
+            buildMaps(quads[i], outputSizes[i], *batch_[i]);
+        }
+    });
+
+    cv::parallel_for_(cv::Range(0, numQuads), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            outputs[i].create(outputSizes[i], inputImage.type());
+            cv::remap(inputImage, outputs[i], batch_[i]->map1, batch_[i]->map2, cv::INTER_LINEAR);
+        }
+    });
+
+    evict();
+}
+
+
+/**
+ * @brief Finds convex four-sided contours in a preprocessed (edge) image.
+ *
+ * @param preprocessedImage A binary image, e.g. from preprocessImageForContourDetection().
+ * @param minArea Minimum contour area in pixels.
+ * @return std::vector<std::vector<cv::Point2f>> The quads, corners ordered top-left, top-right, bottom-left, bottom-right.
+ */
+std::vector<std::vector<cv::Point2f>> findQuads(const cv::Mat& preprocessedImage, double minArea) {
+    std::vector<std::vector<cv::Point2f>> quads;
+    if (preprocessedImage.empty()) {
+        std::cerr << "Error: The input image is empty." << std::endl;
+        return quads;
+    }
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(preprocessedImage, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    std::vector<cv::Point> polygon;
+    for (const auto& contour : contours) {
+        if (cv::contourArea(contour) <= minArea) {
+            continue;
+        }
+
+        cv::approxPolyDP(contour, polygon, 0.02 * cv::arcLength(contour, true), true);
+        if (polygon.size() != 4 || !cv::isContourConvex(polygon)) {
+            continue;
+        }
+
+        // top-left has the smallest x + y, bottom-right the largest; top-right the largest x - y, bottom-left the smallest
+        std::vector<cv::Point2f> quad(4);
+        auto sum = [](const cv::Point& p) { return p.x + p.y; };
+        auto difference = [](const cv::Point& p) { return p.x - p.y; };
+        quad[0] = *std::min_element(polygon.begin(), polygon.end(), [&](const cv::Point& a, const cv::Point& b) { return sum(a) < sum(b); });
+        quad[1] = *std::max_element(polygon.begin(), polygon.end(), [&](const cv::Point& a, const cv::Point& b) { return difference(a) < difference(b); });
+        quad[2] = *std::min_element(polygon.begin(), polygon.end(), [&](const cv::Point& a, const cv::Point& b) { return difference(a) < difference(b); });
+        quad[3] = *std::max_element(polygon.begin(), polygon.end(), [&](const cv::Point& a, const cv::Point& b) { return sum(a) < sum(b); });
+        quads.push_back(quad);
+    }
+
+    return quads;
+}
+
+
+/**
+ * @brief Detects all quads of an image and warps them in one batch.
+ *
+ * @param bgrImage The input BGR image.
+ * @param warper The warper; keep it alive between frames so unchanged quads hit its cache.
+ * @param outputSize The size of every warped image.
+ * @param outputs The warped images, one per detected quad.
+ * @param minArea Minimum contour area of a quad in pixels.
+ * @return std::vector<std::vector<cv::Point2f>> The detected quads.
+ */
+std::vector<std::vector<cv::Point2f>> warpDetectedQuads(const cv::Mat& bgrImage, QuadWarper& warper, const cv::Size& outputSize, std::vector<cv::Mat>& outputs, double minArea) {
+    std::vector<std::vector<cv::Point2f>> quads = findQuads(preprocessImageForContourDetection(bgrImage), minArea);
+    warper.warp(bgrImage, quads, outputSize, outputs);
+    return quads;
+}
@@ -1,4 +1,7 @@
 #pragma once
+#include <list>
+#include <map>
+#include <vector>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -12,3 +15,56 @@
  * @return The warped image.
  */
 cv::Mat warpImage(const cv::Mat& inputImage, const std::vector<cv::Point2f>& sourcePoints, int width, int height);
+
+
+// Warps many quads of the same source image in parallel into reused outputs. The remap table of every
+// (quad, output size) pair is cached, so quads whose corners did not change since an earlier frame skip
+// cv::getPerspectiveTransform and the per-pixel transform entirely.
+class QuadWarper {
+public:
+    explicit QuadWarper(std::size_t maxCacheEntries = 256);
+
+    // warp every quad (4 points in the order of warpImage()) to outputSize; outputs[i] is reused when possible
+    void warp(const cv::Mat& inputImage, const std::vector<std::vector<cv::Point2f>>& quads, const cv::Size& outputSize, std::vector<cv::Mat>& outputs);
+
+    // same, with one output size per quad
+    void warp(const cv::Mat& inputImage, const std::vector<std::vector<cv::Point2f>>& quads, const std::vector<cv::Size>& outputSizes, std::vector<cv::Mat>& outputs);
+
+    void clearCache();
+
+    std::size_t cacheSize() const { return cache_.size(); }
+    std::size_t cacheHits() const { return cacheHits_; }
+    std::size_t cacheMisses() const { return cacheMisses_; }
+
+private:
+    // corners in 1/32 pixel and the output size
+    typedef std::vector<int> WarpKey;
+
+    // keys from the most to the least recently used
+    typedef std::list<WarpKey> UsageList;
+
+    struct CachedWarp {
+        cv::Mat map1;
+        cv::Mat map2;
+        UsageList::iterator usage;
+    };
+
+    static WarpKey makeKey(const std::vector<cv::Point2f>& quad, const cv::Size& outputSize);
+    static void buildMaps(const std::vector<cv::Point2f>& quad, const cv::Size& outputSize, CachedWarp& warp);
+    void evict();
+
+    std::size_t maxCacheEntries_;
+    std::map<WarpKey, CachedWarp> cache_;
+    UsageList usage_;
+    std::size_t cacheHits_ = 0;
+    std::size_t cacheMisses_ = 0;
+
+    std::vector<CachedWarp*> batch_;
+};
+
+
+// find convex four-sided contours (e.g. cards, documents) in a preprocessed image, corners in the order of warpImage()
+std::vector<std::vector<cv::Point2f>> findQuads(const cv::Mat& preprocessedImage, double minArea = 1000.0);
+
+// detect the quads of a BGR image with preprocessImageForContourDetection() + findQuads() and warp all of them
+std::vector<std::vector<cv::Point2f>> warpDetectedQuads(const cv::Mat& bgrImage, QuadWarper& warper, const cv::Size& outputSize, std::vector<cv::Mat>& outputs, double minArea = 1000.0);
\ No newline at end of file
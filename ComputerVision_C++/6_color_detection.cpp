@@ -1,6 +1,138 @@
 #include <iostream>
+#include <algorithm>
 #include <opencv2/opencv.hpp>
 #include "6_color_detection.h"
+#include "9_pose_tracking.h"
+
+
+/**
+ * @brief Builds the summed-volume table of the HSV histogram of a set of frames.
+ *
+ * @param bgrFrames The frames in the BGR color space; all their pixels are counted.
+ */
+void HSVHistogram::build(const std::vector<cv::Mat>& bgrFrames) {
+    table_.assign(static_cast<std::size_t>(hueBins + 1) * (svBins + 1) * (svBins + 1), 0);
+    totalPixels_ = 0;
+
+    // histogram, stored shifted by one bin so the prefix sums below have a zero border
+    cv::Mat hsvImage;
+    for (const cv::Mat& frame : bgrFrames) {
+        if (frame.empty()) {
+            continue;
+        }
+        cv::cvtColor(frame, hsvImage, cv::COLOR_BGR2HSV);
+
+        for (int y = 0; y < hsvImage.rows; y++) {
+            const uchar* pixel = hsvImage.ptr<uchar>(y);
+            for (int x = 0; x < hsvImage.cols; x++, pixel += 3) {
+                table_[index(pixel[0] + 1, (pixel[1] >> svShift) + 1, (pixel[2] >> svShift) + 1)]++;
+            }
+        }
+        totalPixels_ += static_cast<int64>(hsvImage.total());
+    }
+
+    // 3D prefix sums, one axis at a time
+    for (int h = 1; h <= hueBins; h++) {
+        for (int s = 0; s <= svBins; s++) {
+            for (int v = 0; v <= svBins; v++) {
+                table_[index(h, s, v)] += table_[index(h - 1, s, v)];
+            }
+        }
+    }
+    for (int h = 0; h <= hueBins; h++) {
+        for (int s = 1; s <= svBins; s++) {
+            for (int v = 0; v <= svBins; v++) {
+                table_[index(h, s, v)] += table_[index(h, s - 1, v)];
+            }
+        }
+    }
+    for (int h = 0; h <= hueBins; h++) {
+        for (int s = 0; s <= svBins; s++) {
+            for (int v = 1; v <= svBins; v++) {
+                table_[index(h, s, v)] += table_[index(h, s, v - 1)];
+            }
+        }
+    }
+}
+
+
+// pixels with hue in [h0, h1], saturation bin in [s0, s1] and value bin in [v0, v1] (inclusion-exclusion over 8 corners)
+int64 HSVHistogram::boxSum(int h0, int h1, int s0, int s1, int v0, int v1) const {
+    if (h0 > h1 || s0 > s1 || v0 > v1) {
+        return 0;
+    }
+
+    h1++; s1++; v1++;
+    return table_[index(h1, s1, v1)] - table_[index(h0, s1, v1)] - table_[index(h1, s0, v1)] - table_[index(h1, s1, v0)]
+        + table_[index(h0, s0, v1)] + table_[index(h0, s1, v0)] + table_[index(h1, s0, v0)] - table_[index(h0, s0, v0)];
+}
+
+
+/**
+ * @brief Counts the pixels of the histogram frames inside an HSV range in constant time.
+ *
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @return int64 The number of pixels in the range (saturation and value bounds rounded to bins of 4).
+ */
+int64 HSVHistogram::countInRange(const cv::Point3f& lower, const cv::Point3f& upper) const {
+    if (table_.empty()) {
+        return 0;
+    }
+
+    int h0 = std::max(0, cvRound(lower.x));
+    int h1 = std::min(hueBins - 1, cvRound(upper.x));
+    int s0 = std::max(0, cvRound(lower.y)) >> svShift;
+    int s1 = std::min(255, cvRound(upper.y)) >> svShift;
+    int v0 = std::max(0, cvRound(lower.z)) >> svShift;
+    int v1 = std::min(255, cvRound(upper.z)) >> svShift;
+
+    if (h0 > h1) {
+        return boxSum(h0, hueBins - 1, s0, s1, v0, v1) + boxSum(0, h1, s0, s1, v0, v1);
+    }
+    return boxSum(h0, h1, s0, s1, v0, v1);
+}
+
+
+/**
+ * @brief Reads frames evenly spread over a video.
+ *
+ * @param video An opened video capture; its position is moved.
+ * @param numSamples Number of frames to read.
+ * @return std::vector<cv::Mat> The sampled frames (fewer if the video is shorter or cannot seek).
+ */
+std::vector<cv::Mat> sampleVideoFrames(cv::VideoCapture& video, int numSamples) {
+    std::vector<cv::Mat> frames;
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source." << std::endl;
+        return frames;
+    }
+
+    int frameCount = static_cast<int>(video.get(cv::CAP_PROP_FRAME_COUNT));
+    for (int i = 0; i < numSamples; i++) {
+        if (frameCount > 0) {
+            video.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(i) * frameCount / numSamples);
+        }
+
+        cv::Mat frame;
+        if (!video.read(frame)) {
+            break;
+        }
+        frames.push_back(frame);
+    }
+
+    return frames;
+}
+
+
+// Shared between the trackbar callbacks and the tuner loop
+struct HSVTunerState {
+    bool changed = true;
+};
+
+static void onHSVTrackbarChange(int, void* userdata) {
+    static_cast<HSVTunerState*>(userdata)->changed = true;
+}
 
 
 /**
@@ -9,39 +141,317 @@
  * @param bgrImage Input image in the BGR color space.
  */
 void interactiveHSVColorRangeSelection(const cv::Mat& bgrImage) {
-    // Convert BGR image to HSV
-    cv::Mat hsvImage;
-    cv::cvtColor(bgrImage, hsvImage, cv::COLOR_BGR2HSV);
+    cv::Point3f lower, upper;
+    interactiveHSVColorRangeSelection(std::vector<cv::Mat>{ bgrImage }, lower, upper);
+}
+
+
+/**
+ * @brief Displays an interactive window with trackbars to select a color range across several frames.
+ *
+ * The HSV histogram of all frames is built once, so the number and share of selected pixels is updated in
+ * constant time whenever a trackbar moves. The mask preview is only recomputed after a change, on a copy of
+ * the current frame reduced to previewWidth. Use 'n' and 'p' to step through the frames and 'Esc' to finish.
+ * A hue minimum above the hue maximum wraps around 179 -> 0 (for red objects).
+ *
+ * @param bgrFrames Input frames in the BGR color space.
+ * @param lower The selected lower bound for the HSV color range.
+ * @param upper The selected upper bound for the HSV color range.
+ * @param previewWidth Width of the preview; larger frames are reduced to it.
+ * @return true if a range was selected, false if there were no frames.
+ */
+bool interactiveHSVColorRangeSelection(const std::vector<cv::Mat>& bgrFrames, cv::Point3f& lower, cv::Point3f& upper, int previewWidth) {
+    // Reduced resolution copies for the preview
+    std::vector<cv::Mat> previews;
+    for (const cv::Mat& frame : bgrFrames) {
+        if (frame.empty()) {
+            continue;
+        }
+
+        cv::Mat preview = frame;
+        if (previewWidth > 0 && frame.cols > previewWidth) {
+            double scale = static_cast<double>(previewWidth) / frame.cols;
+            cv::resize(frame, preview, cv::Size(), scale, scale, cv::INTER_AREA);
+        }
+        previews.push_back(preview);
+    }
+
+    if (previews.empty()) {
+        std::cerr << "Error: No frames for the HSV color range selection." << std::endl;
+        return false;
+    }
+
+    HSVHistogram histogram;
+    histogram.build(bgrFrames);
 
     // Define the color range
     int hueMinimum = 0, hueMaximum = 19;
     int saturationMinimum = 110, saturationMaximum = 240;
     int valueMinimum = 153, valueMaximum = 255;
 
-    // Create a window with trackbars
+    // Create a window with trackbars; they only flag a change, the work is done in the loop below
+    HSVTunerState state;
     cv::namedWindow("Trackbars", cv::WINDOW_NORMAL);
-    cv::createTrackbar("Hue Min", "Trackbars", &hueMinimum, 179);
-    cv::createTrackbar("Hue Max", "Trackbars", &hueMaximum, 179);
-    cv::createTrackbar("Sat Min", "Trackbars", &saturationMinimum, 255);
-    cv::createTrackbar("Sat Max", "Trackbars", &saturationMaximum, 255);
-    cv::createTrackbar("Val Min", "Trackbars", &valueMinimum, 255);
-    cv::createTrackbar("Val Max", "Trackbars", &valueMaximum, 255);
+    cv::createTrackbar("Hue Min", "Trackbars", &hueMinimum, 179, onHSVTrackbarChange, &state);
+    cv::createTrackbar("Hue Max", "Trackbars", &hueMaximum, 179, onHSVTrackbarChange, &state);
+    cv::createTrackbar("Sat Min", "Trackbars", &saturationMinimum, 255, onHSVTrackbarChange, &state);
+    cv::createTrackbar("Sat Max", "Trackbars", &saturationMaximum, 255, onHSVTrackbarChange, &state);
+    cv::createTrackbar("Val Min", "Trackbars", &valueMinimum, 255, onHSVTrackbarChange, &state);
+    cv::createTrackbar("Val Max", "Trackbars", &valueMaximum, 255, onHSVTrackbarChange, &state);
+
+    std::size_t current = 0;
+    cv::Mat mask;
 
     while (true) {
-        // Update the color range based on trackbar values
-        cv::Scalar lower(hueMinimum, saturationMinimum, valueMinimum);
-        cv::Scalar upper(hueMaximum, saturationMaximum, valueMaximum);
+        if (state.changed) {
+            state.changed = false;
+
+            lower = cv::Point3f(static_cast<float>(hueMinimum), static_cast<float>(saturationMinimum), static_cast<float>(valueMinimum));
+            upper = cv::Point3f(static_cast<float>(hueMaximum), static_cast<float>(saturationMaximum), static_cast<float>(valueMaximum));
+
+            // Detect the color on the preview only; the mask is what gets displayed, so it is built with the
+            // vectorized kernel into a reused buffer rather than skipped
+            applyColorMaskFused(previews[current], lower, upper, mask);
 
-        // Detect the color
-        cv::Mat mask;
-        cv::inRange(hsvImage, lower, upper, mask);
+            int64 selected = histogram.countInRange(lower, upper);
+            double percentage = 100.0 * selected / std::max<int64>(histogram.totalPixels(), 1);
 
-        // Display the mask
-        cv::imshow("Mask", mask);
+            std::string text = cv::format("frame %d/%d  selected %lld px (%.2f%%)", static_cast<int>(current) + 1,
+                static_cast<int>(previews.size()), static_cast<long long>(selected), percentage);
+            // Display the mask
+            cv::imshow("Mask", mask);
+            cv::setWindowTitle("Mask", text);
+        }
 
-        // Break the loop if the 'Esc' key is pressed
-        if (cv::waitKey(1) == 27) {
+        // Wait for a key instead of spinning; trackbar events are handled while waiting
+        int key = cv::waitKey(30);
+        if (key == 27) {
             break;
         }
+        if (key == 'n' || key == 'p') {
+            std::size_t count = previews.size();
+            current = key == 'n' ? (current + 1) % count : (current + count - 1) % count;
+            state.changed = true;
+        }
     }
-}
\ No newline at end of file
+
+    std::cout << "Selected HSV range: lower(" << lower.x << ", " << lower.y << ", " << lower.z
+        << "), upper(" << upper.x << ", " << upper.y << ", " << upper.z << ")" << std::endl;
+    return true;
+}
+
+
+/**
+ * @brief Creates an empty color classifier.
+ *
+ * @param bitsPerChannel Number of bits of each BGR channel used to index the table (4 to 8). With fewer than
+ *                       8 bits, every table cell is classified by the color at its center.
+ */
+ColorClassifier::ColorClassifier(int bitsPerChannel)
+    : bits_(std::min(std::max(bitsPerChannel, 4), 8)), shift_(8 - bits_) {
+}
+
+
+int ColorClassifier::addHSVRange(const cv::Point3f& lower, const cv::Point3f& upper) {
+    CV_Assert(ranges_.size() < 255);
+    ranges_.push_back(ColorRange{ true, lower, upper });
+    return static_cast<int>(ranges_.size());
+}
+
+
+int ColorClassifier::addBGRRange(const cv::Point3f& lower, const cv::Point3f& upper) {
+    CV_Assert(ranges_.size() < 255);
+    ranges_.push_back(ColorRange{ false, lower, upper });
+    return static_cast<int>(ranges_.size());
+}
+
+
+/**
+ * @brief Builds the BGR -> label lookup table from the added ranges.
+ *
+ * The center color of every table cell is converted to HSV once with cv::cvtColor and tested against all
+ * ranges, so the per-frame cost no longer depends on the number of classes.
+ */
+void ColorClassifier::compile() {
+    const int levels = 1 << bits_;
+    const int numCells = levels * levels * levels;
+    const int center = shift_ > 0 ? 1 << (shift_ - 1) : 0;
+
+    // one pixel per cell, in table order
+    cv::Mat cellColors(1, numCells, CV_8UC3);
+    uchar* color = cellColors.ptr<uchar>(0);
+    for (int b = 0; b < levels; b++) {
+        for (int g = 0; g < levels; g++) {
+            for (int r = 0; r < levels; r++, color += 3) {
+                color[0] = static_cast<uchar>((b << shift_) + center);
+                color[1] = static_cast<uchar>((g << shift_) + center);
+                color[2] = static_cast<uchar>((r << shift_) + center);
+            }
+        }
+    }
+
+    cv::Mat cellHSV;
+    cv::cvtColor(cellColors, cellHSV, cv::COLOR_BGR2HSV);
+
+    lut_.assign(numCells, 0);
+    const uchar* bgr = cellColors.ptr<uchar>(0);
+    const uchar* hsv = cellHSV.ptr<uchar>(0);
+
+    for (int cell = 0; cell < numCells; cell++, bgr += 3, hsv += 3) {
+        for (std::size_t i = 0; i < ranges_.size(); i++) {
+            const ColorRange& range = ranges_[i];
+            const uchar* value = range.hsv ? hsv : bgr;
+
+            bool inFirst = range.hsv && range.lower.x > range.upper.x
+                ? (value[0] >= range.lower.x || value[0] <= range.upper.x)
+                : (value[0] >= range.lower.x && value[0] <= range.upper.x);
+
+            if (inFirst && value[1] >= range.lower.y && value[1] <= range.upper.y && value[2] >= range.lower.z && value[2] <= range.upper.z) {
+                lut_[cell] = static_cast<uchar>(i + 1);
+                break;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Labels every pixel of a frame with its color class.
+ *
+ * @param bgrImage The input CV_8UC3 BGR image.
+ * @param labels The output CV_8UC1 label image (0 = background, i + 1 = class i); reused if it has the right size.
+ */
+void ColorClassifier::classify(const cv::Mat& bgrImage, cv::Mat& labels) const {
+    CV_Assert(bgrImage.type() == CV_8UC3 && !lut_.empty());
+
+    labels.create(bgrImage.size(), CV_8UC1);
+    const uchar* lut = lut_.data();
+    const int width = bgrImage.cols;
+
+    cv::parallel_for_(cv::Range(0, bgrImage.rows), [&](const cv::Range& rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            const uchar* src = bgrImage.ptr<uchar>(y);
+            uchar* dst = labels.ptr<uchar>(y);
+
+            for (int x = 0; x < width; x++, src += 3) {
+                dst[x] = lut[lookupIndex(src)];
+            }
+        }
+    });
+}
+
+
+/**
+ * @brief Writes one binary mask per color class in a single pass over the frame.
+ *
+ * @param bgrImage The input CV_8UC3 BGR image.
+ * @param masks The output CV_8UC1 masks, one per class in the order the ranges were added.
+ */
+void ColorClassifier::classifyMasks(const cv::Mat& bgrImage, std::vector<cv::Mat>& masks) const {
+    CV_Assert(bgrImage.type() == CV_8UC3 && !lut_.empty());
+
+    const int numClasses = static_cast<int>(ranges_.size());
+    masks.resize(numClasses);
+    for (cv::Mat& mask : masks) {
+        mask.create(bgrImage.size(), CV_8UC1);
+    }
+
+    const uchar* lut = lut_.data();
+    const int width = bgrImage.cols;
+
+    cv::parallel_for_(cv::Range(0, bgrImage.rows), [&](const cv::Range& rows) {
+        std::vector<uchar*> dst(numClasses);
+
+        for (int y = rows.start; y < rows.end; y++) {
+            const uchar* src = bgrImage.ptr<uchar>(y);
+            for (int i = 0; i < numClasses; i++) {
+                dst[i] = masks[i].ptr<uchar>(y);
+                std::fill(dst[i], dst[i] + width, 0);
+            }
+
+            for (int x = 0; x < width; x++, src += 3) {
+                int label = lut[lookupIndex(src)];
+                if (label > 0) {
+                    dst[label - 1][x] = 255;
+                }
+            }
+        }
+    });
+}
+
+
+/**
+ * @brief Finds the centroid of every color class in a single pass, without building masks.
+ *
+ * Like findObjectPositionInColorRange(), the frame is split into row bands with their own pixel counts and
+ * coordinate sums per class, which are added up at the end.
+ *
+ * @param bgrImage The input CV_8UC3 BGR image.
+ * @param areas If not nullptr, receives the number of pixels of every class.
+ * @return std::vector<cv::Point2f> The centroid of every class, or (-1, -1) for classes without pixels.
+ */
+std::vector<cv::Point2f> ColorClassifier::findCentroids(const cv::Mat& bgrImage, std::vector<int64>* areas) const {
+    CV_Assert(bgrImage.type() == CV_8UC3 && !lut_.empty());
+
+    const int numLabels = static_cast<int>(ranges_.size()) + 1;
+    const int numBands = std::max(1, std::min(bgrImage.rows, std::max(1, cv::getNumThreads()) * 4));
+    const uchar* lut = lut_.data();
+    const int width = bgrImage.cols;
+
+    // count, sum x and sum y per label and band
+    std::vector<int64> partials(static_cast<std::size_t>(numBands) * numLabels * 3, 0);
+
+    cv::parallel_for_(cv::Range(0, numBands), [&](const cv::Range& bands) {
+        std::vector<int64> rowCount(numLabels);
+        std::vector<int64> rowSumX(numLabels);
+
+        for (int band = bands.start; band < bands.end; band++) {
+            int rowStart = static_cast<int>(static_cast<int64>(bgrImage.rows) * band / numBands);
+            int rowEnd = static_cast<int>(static_cast<int64>(bgrImage.rows) * (band + 1) / numBands);
+            int64* sums = &partials[static_cast<std::size_t>(band) * numLabels * 3];
+
+            for (int y = rowStart; y < rowEnd; y++) {
+                const uchar* src = bgrImage.ptr<uchar>(y);
+                std::fill(rowCount.begin(), rowCount.end(), 0);
+                std::fill(rowSumX.begin(), rowSumX.end(), 0);
+
+                for (int x = 0; x < width; x++, src += 3) {
+                    int label = lut[lookupIndex(src)];
+                    rowCount[label]++;
+                    rowSumX[label] += x;
+                }
+
+                // the background (label 0) is counted but never reported
+                for (int label = 1; label < numLabels; label++) {
+                    sums[label * 3] += rowCount[label];
+                    sums[label * 3 + 1] += rowSumX[label];
+                    sums[label * 3 + 2] += rowCount[label] * y;
+                }
+            }
+        }
+    });
+
+    std::vector<cv::Point2f> centroids(numLabels - 1, cv::Point2f(-1, -1));
+    if (areas != nullptr) {
+        areas->assign(numLabels - 1, 0);
+    }
+
+    for (int label = 1; label < numLabels; label++) {
+        int64 count = 0, sumX = 0, sumY = 0;
+        for (int band = 0; band < numBands; band++) {
+            const int64* sums = &partials[(static_cast<std::size_t>(band) * numLabels + label) * 3];
+            count += sums[0];
+            sumX += sums[1];
+            sumY += sums[2];
+        }
+
+        if (areas != nullptr) {
+            (*areas)[label - 1] = count;
+        }
+        if (count > 0) {
+            centroids[label - 1] = cv::Point2f(static_cast<float>(static_cast<double>(sumX) / count), static_cast<float>(static_cast<double>(sumY) / count));
+        }
+    }
+
+    return centroids;
+}
@@ -3,3 +3,81 @@
 
 // HSV color range selection
 void interactiveHSVColorRangeSelection(const cv::Mat& bgrImage);
+
+// HSV color range selection over several frames; returns false if the frames are empty, otherwise the selected range
+bool interactiveHSVColorRangeSelection(const std::vector<cv::Mat>& bgrFrames, cv::Point3f& lower, cv::Point3f& upper, int previewWidth = 640);
+
+// read numSamples frames evenly spread over a video, e.g. to tune the color range under changing lighting
+std::vector<cv::Mat> sampleVideoFrames(cv::VideoCapture& video, int numSamples);
+
+
+// Summed-volume table of a 3D HSV histogram: the number of pixels inside any HSV box is found with 8 lookups.
+// Hue keeps all 180 values; saturation and value are binned by 4, so bounds are rounded to their bin.
+class HSVHistogram {
+public:
+    static const int hueBins = 180;
+    static const int svShift = 2;
+    static const int svBins = 256 >> svShift;
+
+    // build the histogram of all pixels of the BGR frames
+    void build(const std::vector<cv::Mat>& bgrFrames);
+
+    // number of pixels in the HSV range; hue wraps around 179 -> 0 when lower.x > upper.x, as in applyColorMaskFused()
+    int64 countInRange(const cv::Point3f& lower, const cv::Point3f& upper) const;
+
+    int64 totalPixels() const { return totalPixels_; }
+
+private:
+    int64 boxSum(int h0, int h1, int s0, int s1, int v0, int v1) const;
+    std::size_t index(int h, int s, int v) const { return (static_cast<std::size_t>(h) * (svBins + 1) + s) * (svBins + 1) + v; }
+
+    // (hueBins + 1) x (svBins + 1) x (svBins + 1) prefix sums with a zero border
+    std::vector<int64> table_;
+    int64 totalPixels_ = 0;
+};
+
+
+// Classifies the pixels of a BGR frame into several color classes with one lookup table access per pixel.
+// Any number of HSV or BGR ranges are compiled into a quantized BGR -> label table; label 0 is the background and
+// class i (in the order added) has label i + 1. Where ranges overlap, the class added first wins.
+class ColorClassifier {
+public:
+    // bitsPerChannel of each of B, G and R index the table: 6 bits = 256 KB (fits in cache), 8 bits = 16 MB and exact
+    explicit ColorClassifier(int bitsPerChannel = 6);
+
+    // add a class for an HSV range (hue wraps around 179 -> 0 when lower.x > upper.x); returns its label
+    int addHSVRange(const cv::Point3f& lower, const cv::Point3f& upper);
+
+    // add a class for a BGR range; returns its label
+    int addBGRRange(const cv::Point3f& lower, const cv::Point3f& upper);
+
+    // build the lookup table; call after adding the ranges and before classifying
+    void compile();
+
+    // label image (CV_8UC1) of a CV_8UC3 BGR frame
+    void classify(const cv::Mat& bgrImage, cv::Mat& labels) const;
+
+    // one CV_8UC1 mask (255 inside the class) per class, all written in a single pass
+    void classifyMasks(const cv::Mat& bgrImage, std::vector<cv::Mat>& masks) const;
+
+    // centroid of every class in a single pass, (-1, -1) for classes without pixels; optionally their areas in pixels
+    std::vector<cv::Point2f> findCentroids(const cv::Mat& bgrImage, std::vector<int64>* areas = nullptr) const;
+
+    int numClasses() const { return static_cast<int>(ranges_.size()); }
+
+private:
+    struct ColorRange {
+        bool hsv;
+        cv::Point3f lower;
+        cv::Point3f upper;
+    };
+
+    int lookupIndex(const uchar* bgr) const {
+        return ((bgr[0] >> shift_) << (2 * bits_)) | ((bgr[1] >> shift_) << bits_) | (bgr[2] >> shift_);
+    }
+
+    int bits_;
+    int shift_;
+    std::vector<ColorRange> ranges_;
+    std::vector<uchar> lut_;
+};
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <numeric>
 #include <opencv2/opencv.hpp>
 #include "7_shape_contour_detection.h"
 
@@ -12,45 +13,37 @@
  * @param erosionSize Size of the erosion kernel.
  * @return cv::Mat Preprocessed image.
  */
-cv::Mat preprocessImageForContourDetection(cv::Mat inputImage, int lowerThreshold, int upperThreshold, int dilationSize, int erosionSize) {
-    // convert the image to grayscale
-    cv::Mat grayImage;
-    cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
-    
-    // Apply Gaussian blur
-    cv::Size kernelSize(5, 5);
-    double sigma = 0;
-    cv::Mat blurredImage;
-    cv::GaussianBlur(grayImage, blurredImage, kernelSize, sigma);
-
-    // Apply Canny edge detection
-    cv::Mat cannyImage;
-    cv::Canny(blurredImage, cannyImage, lowerThreshold, upperThreshold);
-
-    // Apply dilation to connect broken edges and fill gaps
-    cv::Mat dilatedImage;
-    cv::Mat dilationKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * dilationSize + 1, 2 * dilationSize + 1));
-    cv::dilate(cannyImage, dilatedImage, dilationKernel);
-
-    // Apply erosion to remove noise introduced during dilation and refine object boundaries
-    // This combined operation of dilation followed by erosion is called "closing"
-    cv::Mat erodedImage;
-    cv::Mat erosionKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * erosionSize + 1, 2 * erosionSize + 1));
-    cv::erode(dilatedImage, erodedImage, erosionKernel);
-
-    return erodedImage;
+cv::Mat preprocessImageForContourDetection(const cv::Mat& inputImage, int lowerThreshold, int upperThreshold, int dilationSize, int erosionSize) {
+    ContourPreprocessor preprocessor(lowerThreshold, upperThreshold, dilationSize, erosionSize);
+    return preprocessor.process(inputImage);
 }
 
 
 /**
  * @brief Finds and draws contours on a given preprocessed image if their area is above the specified threshold.
  *
+ * The images are taken by value, so temporaries and const images can be passed; like any cv::Mat copy,
+ * drawingImage shares its pixels with the caller's image, which receives the contours as well.
+ *
  * @param preprocessedImage Input image after preprocessing (e.g., edge detection, dilation, and erosion).
  * @param drawingImage Image to draw the contours on.
  * @param minArea Minimum area for a contour to be drawn.
  * @return cv::Mat Image with drawn contours.
  */
 cv::Mat findAndDrawContours(cv::Mat preprocessedImage, cv::Mat drawingImage, double minArea) {
+    return findAndDrawContoursInPlace(preprocessedImage, drawingImage, minArea);
+}
+
+
+/**
+ * @brief Finds contours on a preprocessed image and draws the ones with an area above minArea into drawingImage.
+ *
+ * @param preprocessedImage Input image after preprocessing (e.g., edge detection, dilation, and erosion).
+ * @param drawingImage Image to draw the contours on, modified in place.
+ * @param minArea Minimum area for a contour to be drawn.
+ * @return cv::Mat drawingImage (sharing its pixels), or an empty image on error.
+ */
+cv::Mat findAndDrawContoursInPlace(const cv::Mat& preprocessedImage, cv::Mat& drawingImage, double minArea) {
     // Check if the input images are empty
     if (preprocessedImage.empty() || drawingImage.empty()) {
         std::cerr << "Error: One or both input images are empty." << std::endl;
@@ -81,4 +74,342 @@ cv::Mat findAndDrawContours(cv::Mat preprocessedImage, cv::Mat drawingImage, dou
 }
 
 
+/**
+ * @brief Creates a contour preprocessor; the structuring elements are built once here.
+ *
+ * @param lowerThreshold Lower threshold for Canny edge detection.
+ * @param upperThreshold Upper threshold for Canny edge detection.
+ * @param dilationSize Size of the dilation kernel.
+ * @param erosionSize Size of the erosion kernel.
+ */
+ContourPreprocessor::ContourPreprocessor(int lowerThreshold, int upperThreshold, int dilationSize, int erosionSize)
+    : lowerThreshold_(lowerThreshold), upperThreshold_(upperThreshold), sameKernels_(dilationSize == erosionSize) {
+    dilationKernel_ = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * dilationSize + 1, 2 * dilationSize + 1));
+    erosionKernel_ = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * erosionSize + 1, 2 * erosionSize + 1));
+}
+
+
+/**
+ * @brief Preprocesses an image for contour detection by applying Gaussian blur, Canny edge detection, dilation, and erosion.
+ *
+ * Gives the same result as preprocessImageForContourDetection(), but every intermediate image is a member that
+ * keeps its buffer between calls, so processing frames of the same size does not allocate them again.
+ *
+ * @param inputImage a BGR image.
+ * @return const cv::Mat& Preprocessed image, valid until the next call.
+ */
+const cv::Mat& ContourPreprocessor::process(const cv::Mat& inputImage) {
+    // convert the image to grayscale
+    cv::cvtColor(inputImage, grayImage_, cv::COLOR_BGR2GRAY);
+
+    // Apply Gaussian blur
+    cv::GaussianBlur(grayImage_, blurredImage_, cv::Size(5, 5), 0);
+
+    // Apply Canny edge detection
+    cv::Canny(blurredImage_, cannyImage_, lowerThreshold_, upperThreshold_);
+
+    // Dilation to connect broken edges followed by erosion to refine the boundaries ("closing").
+    // With equal kernel sizes this is a single morphological closing.
+    if (sameKernels_) {
+        cv::morphologyEx(cannyImage_, closedImage_, cv::MORPH_CLOSE, dilationKernel_);
+    }
+    else {
+        cv::dilate(cannyImage_, dilatedImage_, dilationKernel_);
+        cv::erode(dilatedImage_, closedImage_, erosionKernel_);
+    }
+
+    return closedImage_;
+}
+
+
+/**
+ * @brief Draws the contours of the last processed image with area greater than minArea.
+ *
+ * Same as findAndDrawContoursInPlace(result(), drawingImage, minArea), but the contour and hierarchy vectors are reused.
+ *
+ * @param drawingImage Image to draw the contours on, with the size of the processed image.
+ * @param minArea Minimum area for a contour to be drawn.
+ */
+void ContourPreprocessor::drawContours(cv::Mat& drawingImage, double minArea) {
+    if (closedImage_.empty() || closedImage_.size() != drawingImage.size()) {
+        std::cerr << "Error: The drawing image does not match the processed image." << std::endl;
+        return;
+    }
+
+    cv::findContours(closedImage_, contours_, hierarchy_, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+
+    for (int i = 0; i < static_cast<int>(contours_.size()); i++) {
+        if (cv::contourArea(contours_[i]) > minArea) {
+            cv::drawContours(drawingImage, contours_, i, cv::Scalar(0, 255, 0), 2, cv::LINE_8, hierarchy_, 0);
+        }
+    }
+}
+
+
+// Core rectangles (without halo) of a regular tiling of an image
+static std::vector<cv::Rect> makeTiles(const cv::Size& imageSize, int tileSize) {
+    std::vector<cv::Rect> tiles;
+    for (int y = 0; y < imageSize.height; y += tileSize) {
+        for (int x = 0; x < imageSize.width; x += tileSize) {
+            tiles.push_back(cv::Rect(x, y, tileSize, tileSize) & cv::Rect(cv::Point(0, 0), imageSize));
+        }
+    }
+    return tiles;
+}
+
+
+/**
+ * @brief Preprocesses a very large image for contour detection in overlapping tiles, in parallel.
+ *
+ * Every step (grayscale conversion, Gaussian blur, Canny, dilation and erosion) runs per tile on the tile core plus
+ * a halo, in tile-sized buffers that each thread reuses for all of its tiles; only the core of the final binary
+ * tile is copied to the output, so no full-size intermediate image is allocated. The halo is the sum of the blur
+ * radius (2 pixels), cannyHalo and dilationSize + erosionSize. With cannyHalo >= 2 (Sobel aperture / 2 + 1, for
+ * the gradient and the non-maximum suppression) the gradients and the morphology of every core pixel are the same
+ * as in preprocessImageForContourDetection(). Canny's hysteresis can follow a weak edge arbitrarily far, though:
+ * a weak edge pixel whose only connection to a strong edge leaves the halo is dropped, so the result can miss
+ * some weak edge pixels near tile borders. A larger cannyHalo makes that rarer at the cost of more overlap.
+ *
+ * @param inputImage a BGR image.
+ * @param outputImage The preprocessed binary image (same size as the input).
+ * @param tileSize Side length of the tiles in pixels.
+ * @param lowerThreshold Lower threshold for Canny edge detection.
+ * @param upperThreshold Upper threshold for Canny edge detection.
+ * @param dilationSize Size of the dilation kernel.
+ * @param erosionSize Size of the erosion kernel.
+ * @param cannyHalo Pixels of context Canny sees around the tile core, at least 2.
+ */
+void preprocessImageForContourDetectionTiled(const cv::Mat& inputImage, cv::Mat& outputImage, int tileSize, int lowerThreshold, int upperThreshold, int dilationSize, int erosionSize, int cannyHalo) {
+    const int blurHalo = 2;
+    const int halo = blurHalo + std::max(cannyHalo, 2) + dilationSize + erosionSize;
+    const cv::Rect imageRect(cv::Point(0, 0), inputImage.size());
+    const std::vector<cv::Rect> tiles = makeTiles(inputImage.size(), std::max(tileSize, 64));
+
+    const cv::Mat dilationKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * dilationSize + 1, 2 * dilationSize + 1));
+    const cv::Mat erosionKernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * erosionSize + 1, 2 * erosionSize + 1));
+
+    outputImage.create(inputImage.size(), CV_8UC1);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles.size())), [&](const cv::Range& range) {
+        // one workspace per thread, reused for all of its tiles
+        cv::Mat grayTile, blurredTile, cannyTile, dilatedTile, closedTile;
+
+        for (int i = range.start; i < range.end; i++) {
+            const cv::Rect& core = tiles[i];
+            cv::Rect region = cv::Rect(core.x - halo, core.y - halo, core.width + 2 * halo, core.height + 2 * halo) & imageRect;
+
+            cv::cvtColor(inputImage(region), grayTile, cv::COLOR_BGR2GRAY);
+            cv::GaussianBlur(grayTile, blurredTile, cv::Size(5, 5), 0);
+            cv::Canny(blurredTile, cannyTile, lowerThreshold, upperThreshold);
+            cv::dilate(cannyTile, dilatedTile, dilationKernel);
+            cv::erode(dilatedTile, closedTile, erosionKernel);
+            closedTile(core - region.tl()).copyTo(outputImage(core));
+        }
+    });
+}
+
+
+// Contours found in one tile, with the labels of the pixels along the four edges of the tile core
+struct TileContours {
+    cv::Rect core;
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<int> left, right, top, bottom;  // contour index + 1 of each edge pixel, 0 for background
+};
+
+
+// Finds the external contours of one tile and records which contour every foreground pixel on the tile edges belongs to
+static void findTileContours(const cv::Mat& preprocessedImage, TileContours& tile, cv::Mat& labels) {
+    const cv::Rect& core = tile.core;
+    cv::findContours(preprocessedImage(core), tile.contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, core.tl());
+
+    labels.create(core.size(), CV_32SC1);
+    labels.setTo(cv::Scalar(0));
+    for (int i = 0; i < static_cast<int>(tile.contours.size()); i++) {
+        cv::drawContours(labels, tile.contours, i, cv::Scalar(i + 1), cv::FILLED, cv::LINE_8, cv::noArray(), 0, -core.tl());
+    }
+
+    const cv::Mat binary = preprocessedImage(core);
+    auto label = [&](int y, int x) { return binary.at<uchar>(y, x) != 0 ? labels.at<int>(y, x) : 0; };
+
+    tile.left.resize(core.height);
+    tile.right.resize(core.height);
+    for (int y = 0; y < core.height; y++) {
+        tile.left[y] = label(y, 0);
+        tile.right[y] = label(y, core.width - 1);
+    }
+
+    tile.top.resize(core.width);
+    tile.bottom.resize(core.width);
+    for (int x = 0; x < core.width; x++) {
+        tile.top[x] = label(0, x);
+        tile.bottom[x] = label(core.height - 1, x);
+    }
+}
+
+
+// Union-find over the contours of all tiles
+static int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a != b) {
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+
+/**
+ * @brief Finds the external contours of a preprocessed image tile by tile and stitches contours that cross tile borders.
+ *
+ * Each tile runs cv::findContours() on its own, in parallel. Foreground pixels that are 8-connected across a tile border
+ * join their contours; the pieces of such a blob are filled into one mask and traced again, so every blob yields a single
+ * contour just like cv::findContours() with RETR_EXTERNAL on the whole image. Inner contours (holes) are not returned.
+ *
+ * @param preprocessedImage Input binary image after preprocessing.
+ * @param minArea Minimum area for a contour to be returned.
+ * @param tileSize Side length of the tiles in pixels.
+ * @return The stitched external contours with area greater than minArea.
+ */
+std::vector<std::vector<cv::Point>> findContoursTiled(const cv::Mat& preprocessedImage, double minArea, int tileSize) {
+    CV_Assert(preprocessedImage.type() == CV_8UC1);
+
+    tileSize = std::max(tileSize, 64);
+    const int tilesX = (preprocessedImage.cols + tileSize - 1) / tileSize;
+    const std::vector<cv::Rect> cores = makeTiles(preprocessedImage.size(), tileSize);
+    std::vector<TileContours> tiles(cores.size());
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tiles.size())), [&](const cv::Range& range) {
+        cv::Mat labels;
+        for (int i = range.start; i < range.end; i++) {
+            tiles[i].core = cores[i];
+            findTileContours(preprocessedImage, tiles[i], labels);
+        }
+    });
+
+    // global id of every contour
+    std::vector<int> firstId(tiles.size() + 1, 0);
+    for (std::size_t i = 0; i < tiles.size(); i++) {
+        firstId[i + 1] = firstId[i] + static_cast<int>(tiles[i].contours.size());
+    }
+    std::vector<int> parent(firstId.back());
+    std::iota(parent.begin(), parent.end(), 0);
+
+    // join contours whose pixels touch (8-connectivity) across a border; a and b are label arrays along the shared edge
+    auto joinAlongEdge = [&](int tileA, const std::vector<int>& a, int tileB, const std::vector<int>& b) {
+        const int n = static_cast<int>(a.size());
+        for (int i = 0; i < n; i++) {
+            if (a[i] == 0) {
+                continue;
+            }
+            for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); j++) {
+                if (b[j] != 0) {
+                    unite(parent, firstId[tileA] + a[i] - 1, firstId[tileB] + b[j] - 1);
+                }
+            }
+        }
+    };
+
+    for (int i = 0; i < static_cast<int>(tiles.size()); i++) {
+        const int tileX = i % tilesX;
+        const bool hasRight = tileX + 1 < tilesX;
+        const bool hasBelow = i + tilesX < static_cast<int>(tiles.size());
+
+        if (hasRight) {
+            joinAlongEdge(i, tiles[i].right, i + 1, tiles[i + 1].left);
+        }
+        if (hasBelow) {
+            joinAlongEdge(i, tiles[i].bottom, i + tilesX, tiles[i + tilesX].top);
+        }
+
+        // diagonal neighbours across the tile corners
+        if (hasRight && hasBelow) {
+            const TileContours& below = tiles[i + tilesX];
+            const TileContours& belowRight = tiles[i + tilesX + 1];
+            if (tiles[i].bottom.back() != 0 && belowRight.top.front() != 0) {
+                unite(parent, firstId[i] + tiles[i].bottom.back() - 1, firstId[i + tilesX + 1] + belowRight.top.front() - 1);
+            }
+            if (tiles[i + 1].bottom.front() != 0 && below.top.back() != 0) {
+                unite(parent, firstId[i + 1] + tiles[i + 1].bottom.front() - 1, firstId[i + tilesX] + below.top.back() - 1);
+            }
+        }
+    }
+
+    // group the pieces by blob
+    std::vector<std::vector<std::pair<int, int>>> groups(parent.size());
+    for (int i = 0; i < static_cast<int>(tiles.size()); i++) {
+        for (int j = 0; j < static_cast<int>(tiles[i].contours.size()); j++) {
+            groups[findRoot(parent, firstId[i] + j)].push_back(std::make_pair(i, j));
+        }
+    }
+
+    std::vector<std::vector<cv::Point>> contours;
+    for (const auto& group : groups) {
+        if (group.empty()) {
+            continue;
+        }
+
+        if (group.size() == 1) {
+            const std::vector<cv::Point>& contour = tiles[group[0].first].contours[group[0].second];
+            if (cv::contourArea(contour) > minArea) {
+                contours.push_back(contour);
+            }
+            continue;
+        }
+
+        // fill all pieces of the blob into one mask and trace its outer border again
+        cv::Rect bounds;
+        for (const auto& piece : group) {
+            bounds |= cv::boundingRect(tiles[piece.first].contours[piece.second]);
+        }
+
+        cv::Mat mask = cv::Mat::zeros(bounds.size(), CV_8UC1);
+        for (const auto& piece : group) {
+            cv::drawContours(mask, tiles[piece.first].contours, piece.second, cv::Scalar(255), cv::FILLED, cv::LINE_8, cv::noArray(), 0, -bounds.tl());
+        }
+
+        std::vector<std::vector<cv::Point>> stitched;
+        cv::findContours(mask, stitched, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, bounds.tl());
+        for (const std::vector<cv::Point>& contour : stitched) {
+            if (cv::contourArea(contour) > minArea) {
+                contours.push_back(contour);
+            }
+        }
+    }
+
+    return contours;
+}
+
+
+/**
+ * @brief Finds contours tile by tile (see findContoursTiled()) and draws them on the drawing image.
+ *
+ * @param preprocessedImage Input binary image after preprocessing.
+ * @param drawingImage Image to draw the contours on.
+ * @param minArea Minimum area for a contour to be drawn.
+ * @param tileSize Side length of the tiles in pixels.
+ * @return cv::Mat Image with drawn contours.
+ */
+cv::Mat findAndDrawContoursTiled(const cv::Mat& preprocessedImage, cv::Mat& drawingImage, double minArea, int tileSize) {
+    // Check if the input images are empty
+    if (preprocessedImage.empty() || drawingImage.empty()) {
+        std::cerr << "Error: One or both input images are empty." << std::endl;
+        return cv::Mat();
+    }
 
+    // Check if the input images have the same dimensions
+    if (preprocessedImage.size() != drawingImage.size()) {
+        std::cerr << "Error: Input images have different dimensions." << std::endl;
+        return cv::Mat();
+    }
+
+    std::vector<std::vector<cv::Point>> contours = findContoursTiled(preprocessedImage, minArea, tileSize);
+    cv::drawContours(drawingImage, contours, -1, cv::Scalar(0, 255, 0), 2, cv::LINE_8);
+
+    return drawingImage;
+}
@@ -3,8 +3,60 @@
 
 
 // preprocessor directives
-cv::Mat preprocessImageForContourDetection(cv::Mat inputImage, int lowerThreshold = 50, int upperThreshold = 100, int dilationSize = 5, int erosionSize = 1);
+cv::Mat preprocessImageForContourDetection(const cv::Mat& inputImage, int lowerThreshold = 50, int upperThreshold = 100, int dilationSize = 5, int erosionSize = 1);
 
 
 // find and draw contours
-cv::Mat findAndDrawContours(cv::Mat preprocessedImage, cv::Mat drawingImage, double minArea = 1000.0);
\ No newline at end of file
+cv::Mat findAndDrawContours(cv::Mat preprocessedImage, cv::Mat drawingImage, double minArea = 1000.0);
+
+// find contours and draw them into drawingImage in place
+cv::Mat findAndDrawContoursInPlace(const cv::Mat& preprocessedImage, cv::Mat& drawingImage, double minArea = 1000.0);
+
+
+// preprocess a very large image in overlapping tiles in parallel, every step in tile-sized buffers; same result as
+// preprocessImageForContourDetection() except for weak Canny edges connected to a strong edge only beyond cannyHalo
+void preprocessImageForContourDetectionTiled(const cv::Mat& inputImage, cv::Mat& outputImage, int tileSize = 1024, int lowerThreshold = 50, int upperThreshold = 100, int dilationSize = 5, int erosionSize = 1, int cannyHalo = 16);
+
+
+// find the external contours of a preprocessed image tile by tile, stitching contours that cross tile borders
+std::vector<std::vector<cv::Point>> findContoursTiled(const cv::Mat& preprocessedImage, double minArea = 1000.0, int tileSize = 1024);
+
+
+// find contours tile by tile and draw them
+cv::Mat findAndDrawContoursTiled(const cv::Mat& preprocessedImage, cv::Mat& drawingImage, double minArea = 1000.0, int tileSize = 1024);
+
+
+// Stateful version of preprocessImageForContourDetection() for video: owns the intermediate images and the
+// structuring elements and reuses them for every call with the same input size.
+class ContourPreprocessor {
+public:
+    ContourPreprocessor(int lowerThreshold = 50, int upperThreshold = 100, int dilationSize = 5, int erosionSize = 1);
+
+    // preprocess a BGR image; the returned image is owned by the preprocessor and overwritten by the next call
+    const cv::Mat& process(const cv::Mat& inputImage);
+
+    // draw the contours of the last processed image with area greater than minArea
+    void drawContours(cv::Mat& drawingImage, double minArea = 1000.0);
+
+    // intermediate results of the last call
+    const cv::Mat& grayImage() const { return grayImage_; }
+    const cv::Mat& blurredImage() const { return blurredImage_; }
+    const cv::Mat& cannyImage() const { return cannyImage_; }
+    const cv::Mat& result() const { return closedImage_; }
+
+private:
+    int lowerThreshold_;
+    int upperThreshold_;
+    cv::Mat dilationKernel_;
+    cv::Mat erosionKernel_;
+    bool sameKernels_;
+
+    cv::Mat grayImage_;
+    cv::Mat blurredImage_;
+    cv::Mat cannyImage_;
+    cv::Mat dilatedImage_;
+    cv::Mat closedImage_;
+
+    std::vector<std::vector<cv::Point>> contours_;
+    std::vector<cv::Vec4i> hierarchy_;
+};
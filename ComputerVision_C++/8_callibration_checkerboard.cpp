@@ -6,8 +6,15 @@
 #include <opencv2/calib3d.hpp>
 #include <opencv2/highgui.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
 
+#include "3_resize_crop.h"
 #include "8_callibration_checkerboard.h" 
+#include "15_telemetry.h"
 
 
 // Get image paths from a folder
@@ -103,6 +110,426 @@ std::vector<std::vector<cv::Point2f>> detectCorners(const std::vector<std::strin
 }
 
 
+// Finds the checkerboard on a reduced level of the full resolution grayscale image and maps the corners back up.
+// Returns false if the pattern is not visible at that scale.
+static bool findChessboardCornersCoarse(ImagePyramid& pyramid, const cv::Size& patternSize, int downscaleFactor, std::vector<cv::Point2f>& corners) {
+    const double scale = 1.0 / downscaleFactor;
+
+    if (!cv::findChessboardCorners(pyramid.level(scale), patternSize, corners, cv::CALIB_CB_ADAPTIVE_THRESH + cv::CALIB_CB_NORMALIZE_IMAGE + cv::CALIB_CB_FAST_CHECK)) {
+        return false;
+    }
+
+    // pixel centers of the reduced image map to (p + 0.5) * factor - 0.5 in the full image
+    for (cv::Point2f& corner : corners) {
+        corner = pyramid.fromLevel(corner, scale);
+    }
+    return true;
+}
+
+
+// Detects and refines the checkerboard corners of a single image and measures how long it took.
+// With downscaleFactor > 1 the pattern is searched on a reduced image and only refined at full resolution.
+static CornerDetection detectCornersInImage(const std::string& fileName, const cv::Size& patternSize, int downscaleFactor) {
+    CornerDetection detection;
+    detection.fileName = fileName;
+
+    int64 start = cv::getTickCount();
+
+    cv::Mat gray;
+    {
+        TELEMETRY_SCOPE("image decode");
+        if (downscaleFactor > 1) {
+            // decode straight to grayscale, no color image and no conversion
+            gray = cv::imread(fileName, cv::IMREAD_GRAYSCALE);
+        }
+        else {
+            cv::Mat img = cv::imread(fileName);
+            if (!img.empty()) {
+                cv::cvtColor(img, gray, cv::COLOR_RGB2GRAY);
+            }
+        }
+    }
+
+    if (!gray.empty()) {
+        int flags = cv::CALIB_CB_ADAPTIVE_THRESH + cv::CALIB_CB_NORMALIZE_IMAGE + cv::CALIB_CB_FAST_CHECK;
+        cv::Size subPixWindow(11, 11);
+
+        // one pyramid per image, shared by the coarse searches, the full resolution fallback and the refinement
+        ImagePyramid pyramid(gray);
+
+        {
+            TELEMETRY_SCOPE("corner detection");
+            if (downscaleFactor > 1) {
+                // coarse to fine: retry at twice the scale, which is the already computed parent level of the previous try
+                for (int factor = downscaleFactor; factor > 1 && !detection.patternFound; factor /= 2) {
+                    detection.patternFound = findChessboardCornersCoarse(pyramid, patternSize, factor, detection.corners);
+
+                    // the coarse corners can be off by about one reduced pixel, the refinement window has to cover that
+                    int halfWindow = std::max(11, 2 * factor + 3);
+                    subPixWindow = cv::Size(halfWindow, halfWindow);
+                }
+                if (!detection.patternFound) {
+                    // fall back to the full resolution search, e.g. for boards that are too small at the reduced scale
+                    subPixWindow = cv::Size(11, 11);
+                    detection.patternFound = cv::findChessboardCorners(pyramid.frame(), patternSize, detection.corners, flags);
+                }
+            }
+            else {
+                detection.patternFound = cv::findChessboardCorners(pyramid.frame(), patternSize, detection.corners, flags);
+            }
+        }
+
+        if (detection.patternFound) {
+            TELEMETRY_SCOPE("subpixel refinement");
+            cv::cornerSubPix(pyramid.frame(), detection.corners, subPixWindow, cv::Size(-1, -1), cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 30, 0.1));
+        }
+    }
+
+    detection.detectionTimeMs = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+    return detection;
+}
+
+
+/**
+ * @brief Detects and refines checkerboard corners of many images in parallel.
+ *
+ * Every image is loaded, converted and searched on the OpenCV thread pool. The results are stored by
+ * input index, so they are ordered like fileNames no matter which thread finished first.
+ *
+ * @param fileNames A vector of strings representing the file paths of the checkerboard images.
+ * @param patternSize A cv::Size object representing the dimensions of the checkerboard.
+ * @param downscaleFactor If > 1, search the pattern on an image reduced by this factor (then by half of it,
+ *                        and so on, if not found) and refine the corners with cv::cornerSubPix() on the full
+ *                        resolution image (coarse-to-fine).
+ * @return One detection result (found flag, refined corners and detection time) per input file.
+ */
+std::vector<CornerDetection> detectCornersInImages(const std::vector<std::string>& fileNames, const cv::Size& patternSize, int downscaleFactor) {
+    std::vector<CornerDetection> detections(fileNames.size());
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(fileNames.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            detections[i] = detectCornersInImage(fileNames[i], patternSize, downscaleFactor);
+        }
+    }, static_cast<double>(fileNames.size()));
+
+    return detections;
+}
+
+
+// Corner cache file layout: a header followed by one variable size entry per (image hash, pattern size, downscale
+// factor), each entry being a fixed size entry header and cornerCount x/y float pairs. Host-endian.
+struct CornerCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct CornerCacheEntryHeader {
+    uint64_t hash;
+    int32_t patternWidth;
+    int32_t patternHeight;
+    int32_t downscaleFactor;
+    uint32_t patternFound;
+    uint32_t cornerCount;
+    uint32_t reserved;
+};
+
+static const char cornerCacheMagic[4] = { 'C', 'C', 'R', 'N' };
+static const uint32_t cornerCacheVersion = 2;
+
+// (image content hash, pattern width, pattern height, downscale factor); the downscale factor also decides the
+// cv::cornerSubPix() window, so corners refined with different settings are never mixed up
+typedef std::tuple<uint64_t, int, int, int> CornerCacheKey;
+
+static CornerCacheKey makeCornerCacheKey(uint64_t hash, const cv::Size& patternSize, int downscaleFactor) {
+    return CornerCacheKey(hash, patternSize.width, patternSize.height, std::max(downscaleFactor, 1));
+}
+
+struct CornerCacheValue {
+    bool patternFound;
+    std::vector<cv::Point2f> corners;
+};
+
+typedef std::map<CornerCacheKey, CornerCacheValue> CornerCache;
+
+
+// 64 bit FNV-1a hash of the file contents; 0 if the file cannot be read
+static uint64_t hashFileContents(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return 0;
+    }
+
+    std::vector<char> buffer(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : buffer) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+// Content hashes of many files, computed in parallel
+static std::vector<uint64_t> hashFiles(const std::vector<std::string>& fileNames) {
+    std::vector<uint64_t> hashes(fileNames.size());
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(fileNames.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            hashes[i] = hashFileContents(fileNames[i]);
+        }
+    }, static_cast<double>(fileNames.size()));
+
+    return hashes;
+}
+
+
+// Reads a corner cache file; a missing or invalid file gives an empty cache
+static void loadCornerCache(const std::string& fileName, CornerCache& cache) {
+    cache.clear();
+
+    std::ifstream inFile(fileName, std::ios::binary);
+    if (!inFile) {
+        return;
+    }
+
+    CornerCacheHeader header;
+    inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!inFile || std::memcmp(header.magic, cornerCacheMagic, sizeof(header.magic)) != 0 || header.version != cornerCacheVersion) {
+        std::cerr << "Warning: " << fileName << " is not a valid corner cache, all images are detected again." << std::endl;
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        CornerCacheEntryHeader entry;
+        inFile.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+        if (!inFile) {
+            break;
+        }
+
+        // a found pattern has exactly one corner per inner corner of the board, a missing one none;
+        // anything else is a damaged file and nothing after it can be trusted
+        int64 expectedCount = entry.patternFound != 0 ? static_cast<int64>(entry.patternWidth) * entry.patternHeight : 0;
+        if (entry.patternWidth <= 0 || entry.patternHeight <= 0 || entry.cornerCount != expectedCount) {
+            break;
+        }
+
+        CornerCacheValue value;
+        value.patternFound = entry.patternFound != 0;
+        value.corners.resize(entry.cornerCount);
+        inFile.read(reinterpret_cast<char*>(value.corners.data()), static_cast<std::streamsize>(entry.cornerCount * sizeof(cv::Point2f)));
+        if (!inFile) {
+            break;
+        }
+
+        cache[CornerCacheKey(entry.hash, entry.patternWidth, entry.patternHeight, entry.downscaleFactor)] = std::move(value);
+    }
+
+    if (cache.size() < header.entryCount) {
+        std::cerr << "Warning: " << fileName << " is damaged, " << header.entryCount - cache.size() << " cached images are detected again." << std::endl;
+    }
+}
+
+
+// Moves a completely written temporary file over the target file; false (and the temporary file removed) on failure
+static bool replaceFileWith(const std::string& fileName, const std::string& tempFileName) {
+    if (std::rename(tempFileName.c_str(), fileName.c_str()) == 0) {
+        return true;
+    }
+
+    // std::rename does not replace an existing file on Windows
+    std::remove(fileName.c_str());
+    if (std::rename(tempFileName.c_str(), fileName.c_str()) == 0) {
+        return true;
+    }
+
+    std::remove(tempFileName.c_str());
+    return false;
+}
+
+
+// Writes all entries of a corner cache to a temporary file and renames it into place, so an interrupted save
+// leaves the previous cache intact
+static bool saveCornerCache(const std::string& fileName, const CornerCache& cache) {
+    const std::string tempFileName = fileName + ".tmp";
+    std::ofstream outFile(tempFileName, std::ios::binary);
+    if (!outFile) {
+        std::cerr << "Error: Could not open " << tempFileName << " for saving the corner cache." << std::endl;
+        return false;
+    }
+
+    CornerCacheHeader header;
+    std::memcpy(header.magic, cornerCacheMagic, sizeof(header.magic));
+    header.version = cornerCacheVersion;
+    header.entryCount = static_cast<uint32_t>(cache.size());
+    header.reserved = 0;
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& item : cache) {
+        CornerCacheEntryHeader entry;
+        entry.hash = std::get<0>(item.first);
+        entry.patternWidth = std::get<1>(item.first);
+        entry.patternHeight = std::get<2>(item.first);
+        entry.downscaleFactor = std::get<3>(item.first);
+        entry.patternFound = item.second.patternFound ? 1 : 0;
+        entry.cornerCount = static_cast<uint32_t>(item.second.corners.size());
+        entry.reserved = 0;
+
+        outFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        outFile.write(reinterpret_cast<const char*>(item.second.corners.data()), static_cast<std::streamsize>(entry.cornerCount * sizeof(cv::Point2f)));
+    }
+
+    outFile.close();
+    if (!outFile) {
+        std::cerr << "Error: Could not write the corner cache " << tempFileName << std::endl;
+        std::remove(tempFileName.c_str());
+        return false;
+    }
+
+    if (!replaceFileWith(fileName, tempFileName)) {
+        std::cerr << "Error: Could not replace the corner cache " << fileName << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+// Removes the entries of images that are not among the current inputs, so the cache only ever holds the images of
+// the last run instead of growing with every image set it has seen; returns the number of removed entries
+static std::size_t pruneCornerCache(CornerCache& cache, const std::vector<uint64_t>& keptHashes) {
+    std::vector<uint64_t> currentHashes(keptHashes);
+    std::sort(currentHashes.begin(), currentHashes.end());
+
+    std::size_t removed = 0;
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (!std::binary_search(currentHashes.begin(), currentHashes.end(), std::get<0>(it->first))) {
+            it = cache.erase(it);
+            removed++;
+        }
+        else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+
+// Detects the corners of images with known content hashes, taking the ones already in the cache file from it.
+// Cache entries of images not in keptHashes (which should include hashes) are dropped.
+static std::vector<CornerDetection> detectCornersWithCache(const std::vector<std::string>& fileNames, const std::vector<uint64_t>& hashes, const std::vector<uint64_t>& keptHashes, const cv::Size& patternSize, const std::string& cornerCacheFileName, int downscaleFactor) {
+    CornerCache cache;
+    loadCornerCache(cornerCacheFileName, cache);
+    const bool pruned = pruneCornerCache(cache, keptHashes) > 0;
+
+    std::vector<CornerDetection> detections(fileNames.size());
+    std::vector<std::string> missingFiles;
+    std::vector<std::size_t> missingIndices;
+
+    for (std::size_t i = 0; i < fileNames.size(); i++) {
+        auto it = cache.find(makeCornerCacheKey(hashes[i], patternSize, downscaleFactor));
+        if (hashes[i] != 0 && it != cache.end()) {
+            detections[i].fileName = fileNames[i];
+            detections[i].patternFound = it->second.patternFound;
+            detections[i].corners = it->second.corners;
+            detections[i].fromCache = true;
+        }
+        else {
+            missingFiles.push_back(fileNames[i]);
+            missingIndices.push_back(i);
+        }
+    }
+
+    if (missingFiles.empty()) {
+        if (pruned) {
+            saveCornerCache(cornerCacheFileName, cache);
+        }
+        return detections;
+    }
+
+    std::vector<CornerDetection> newDetections = detectCornersInImages(missingFiles, patternSize, downscaleFactor);
+    for (std::size_t m = 0; m < newDetections.size(); m++) {
+        std::size_t i = missingIndices[m];
+
+        // unreadable files are not cached, they are retried next time
+        if (hashes[i] != 0) {
+            cache[makeCornerCacheKey(hashes[i], patternSize, downscaleFactor)] = CornerCacheValue{ newDetections[m].patternFound, newDetections[m].corners };
+        }
+        detections[i] = std::move(newDetections[m]);
+    }
+
+    saveCornerCache(cornerCacheFileName, cache);
+    return detections;
+}
+
+
+/**
+ * @brief Detects checkerboard corners of many images, reusing the corners of images detected in earlier runs.
+ *
+ * Every image is hashed (64 bit FNV-1a of the file contents). Images whose hash, pattern size and downscale
+ * factor are in the corner cache file are not decoded at all; the others are detected in parallel with detectCornersInImages()
+ * and added to the cache, which is then written back. Images without the pattern are cached as well. Entries of
+ * images that are not among fileNames are dropped when the cache is written, so it does not grow across runs.
+ *
+ * @param fileNames A vector of strings representing the file paths of the checkerboard images.
+ * @param patternSize A cv::Size object representing the dimensions of the checkerboard.
+ * @param cornerCacheFileName The corner cache file; created if it does not exist.
+ * @param downscaleFactor If > 1, detect coarse-to-fine on images reduced by this factor (see detectCornersInImages()).
+ * @return One detection result per input file, ordered like fileNames; fromCache marks the cached ones.
+ */
+std::vector<CornerDetection> detectCornersInImagesCached(const std::vector<std::string>& fileNames, const cv::Size& patternSize, const std::string& cornerCacheFileName, int downscaleFactor) {
+    std::vector<uint64_t> hashes = hashFiles(fileNames);
+    return detectCornersWithCache(fileNames, hashes, hashes, patternSize, cornerCacheFileName, downscaleFactor);
+}
+
+
+
+/**
+ * @brief Detects checkerboard corners of all images in parallel and returns the views usable for calibration.
+ *
+ * Unlike detectCorners(), images where the pattern was not found are left out of both Q and the returned
+ * corners, so Q[i] and q[i] always belong to the same view. The detection time of every image is printed
+ * in input order once all images are done.
+ *
+ * @param fileNames A vector of strings representing the file paths of the checkerboard images.
+ * @param patternSize A cv::Size object representing the dimensions of the checkerboard.
+ * @param checkerboardDimensions An array containing the dimensions of the checkerboard.
+ * @param Q A reference to a vector of vectors of 3D points representing the world coordinates of the checkerboard corners.
+ * @param downscaleFactor If > 1, detect coarse-to-fine on images reduced by this factor (see detectCornersInImages()).
+ * @param cornerCacheFileName If not empty, corners are cached in this file (see detectCornersInImagesCached()).
+ * @return A vector of vectors of 2D points representing the detected and refined corners.
+ */
+std::vector<std::vector<cv::Point2f>> detectCornersParallel(const std::vector<std::string>& fileNames, const cv::Size& patternSize, const int checkerboardDimensions[2], std::vector<std::vector<cv::Point3f>>& Q, int downscaleFactor, const std::string& cornerCacheFileName) {
+    std::vector<std::vector<cv::Point2f>> q;
+    std::vector<cv::Point3f> objp = generateWorldCoordinates(checkerboardDimensions);
+
+    std::vector<CornerDetection> detections = cornerCacheFileName.empty()
+        ? detectCornersInImages(fileNames, patternSize, downscaleFactor)
+        : detectCornersInImagesCached(fileNames, patternSize, cornerCacheFileName, downscaleFactor);
+
+    for (CornerDetection& detection : detections) {
+        std::cout << detection.fileName << (detection.patternFound ? " found" : " not found");
+        if (detection.fromCache) {
+            std::cout << " (cached)" << std::endl;
+        }
+        else {
+            std::cout << " (" << detection.detectionTimeMs << " ms)" << std::endl;
+        }
+
+        if (detection.patternFound) {
+            q.push_back(std::move(detection.corners));
+            Q.push_back(objp);
+        }
+    }
+
+    return q;
+}
+
+
 /**
  * @brief Calibrates the camera using the detected checkerboard corners and computes the reprojection error.
  * @param Q The world coordinates of the checkerboard corners.
@@ -110,39 +537,185 @@ std::vector<std::vector<cv::Point2f>> detectCorners(const std::vector<std::strin
  * @param frameSize The size of the images used for calibration.
  * @param K The intrinsic camera matrix to be computed.
  * @param k The distortion coefficients to be computed.
+ * @param useInitialGuess Start the optimization from the given K and k, e.g. a previous calibration of the same camera.
  * @return The reprojection error.
  */
-float calibrateCameraAndComputeErrors(const std::vector<std::vector<cv::Point3f>>& Q, const std::vector<std::vector<cv::Point2f>>& q, const cv::Size& frameSize, cv::Matx33f& K, cv::Vec<float, 5>& k) {
+float calibrateCameraAndComputeErrors(const std::vector<std::vector<cv::Point3f>>& Q, const std::vector<std::vector<cv::Point2f>>& q, const cv::Size& frameSize, cv::Matx33f& K, cv::Vec<float, 5>& k, bool useInitialGuess) {
     std::vector<cv::Mat> rvecs, tvecs;
     int flags = cv::CALIB_FIX_ASPECT_RATIO + cv::CALIB_FIX_K3 +
         cv::CALIB_ZERO_TANGENT_DIST + cv::CALIB_FIX_PRINCIPAL_POINT;
+    if (useInitialGuess) {
+        flags += cv::CALIB_USE_INTRINSIC_GUESS;
+    }
 
     float error = cv::calibrateCamera(Q, q, frameSize, K, k, rvecs, tvecs, flags);
 
     return error;
 }
 
+
+/**
+ * @brief Creates an empty incremental calibration.
+ *
+ * @param patternSize The number of inner corners of the checkerboard.
+ * @param checkerboardDimensions The dimensions of the checkerboard, for the world coordinates of the corners.
+ * @param frameSize The size of the calibration images.
+ * @param cornerCacheFileName If not empty, detected corners are cached in this file across runs.
+ * @param downscaleFactor If > 1, detect coarse-to-fine on images reduced by this factor.
+ */
+IncrementalCalibration::IncrementalCalibration(const cv::Size& patternSize, const int checkerboardDimensions[2], const cv::Size& frameSize, const std::string& cornerCacheFileName, int downscaleFactor)
+    : patternSize_(patternSize), objectPoints_(generateWorldCoordinates(checkerboardDimensions)), frameSize_(frameSize),
+      cornerCacheFileName_(cornerCacheFileName), downscaleFactor_(downscaleFactor), K_(cv::Matx33f::eye()), k_(0, 0, 0, 0, 0) {
+}
+
+
+void IncrementalCalibration::setInitialCalibration(const cv::Matx33f& K, const cv::Vec<float, 5>& k) {
+    K_ = K;
+    k_ = k;
+    calibrated_ = true;
+}
+
+
+// number of added images in which the pattern was found
+std::size_t IncrementalCalibration::numViews() const {
+    std::size_t count = 0;
+    for (const auto& item : views_) {
+        if (item.second.patternFound) {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+/**
+ * @brief Adds calibration images; only new or changed images are detected.
+ *
+ * An image that was already added with the same content hash is skipped; if its content changed, its view is
+ * replaced. With a corner cache, images detected in earlier runs are not decoded at all.
+ *
+ * @param fileNames The paths of the images to add.
+ * @return int The number of new or replaced views in which the pattern was found.
+ */
+int IncrementalCalibration::addImages(const std::vector<std::string>& fileNames) {
+    std::vector<uint64_t> hashes = hashFiles(fileNames);
+
+    std::vector<std::string> newFiles;
+    std::vector<uint64_t> newHashes;
+    for (std::size_t i = 0; i < fileNames.size(); i++) {
+        auto it = views_.find(fileNames[i]);
+        if (it == views_.end() || it->second.hash != hashes[i] || hashes[i] == 0) {
+            newFiles.push_back(fileNames[i]);
+            newHashes.push_back(hashes[i]);
+        }
+    }
+
+    if (newFiles.empty()) {
+        return 0;
+    }
+
+    // the cache keeps the images added before as well as the new ones; replaced contents are dropped
+    std::vector<uint64_t> keptHashes = newHashes;
+    for (const auto& item : views_) {
+        if (std::find(newFiles.begin(), newFiles.end(), item.first) == newFiles.end()) {
+            keptHashes.push_back(item.second.hash);
+        }
+    }
+
+    std::vector<CornerDetection> detections = cornerCacheFileName_.empty()
+        ? detectCornersInImages(newFiles, patternSize_, downscaleFactor_)
+        : detectCornersWithCache(newFiles, newHashes, keptHashes, patternSize_, cornerCacheFileName_, downscaleFactor_);
+
+    int newViews = 0;
+    for (std::size_t i = 0; i < detections.size(); i++) {
+        views_[newFiles[i]] = View{ newHashes[i], detections[i].patternFound, std::move(detections[i].corners) };
+        if (detections[i].patternFound) {
+            newViews++;
+        }
+    }
+
+    return newViews;
+}
+
+
+/**
+ * @brief Calibrates with all views, warm-started from the previous (or initial) K and k when there is one.
+ *
+ * @return float The reprojection error, or -1 if no view contains the pattern.
+ */
+float IncrementalCalibration::calibrate() {
+    std::vector<std::vector<cv::Point3f>> Q;
+    std::vector<std::vector<cv::Point2f>> q;
+    for (const auto& item : views_) {
+        if (item.second.patternFound) {
+            Q.push_back(objectPoints_);
+            q.push_back(item.second.corners);
+        }
+    }
+
+    if (q.empty()) {
+        std::cerr << "Error: No calibration views with a detected checkerboard." << std::endl;
+        return -1.0f;
+    }
+
+    float error = calibrateCameraAndComputeErrors(Q, q, frameSize_, K_, k_, calibrated_);
+    calibrated_ = true;
+    return error;
+}
+
+
 /**
  * @brief Undistorts the images using the computed intrinsic camera matrix and distortion coefficients.
  * @param fileNames The paths to the images to be undistorted.
- * @param mapX The x coordinates of the undistorted image points.
- * @param mapY The y coordinates of the undistorted image points.
+ * @param mapX The x coordinates of the undistorted image points (or the CV_16SC2 map of initUndistortMapsCached()).
+ * @param mapY The y coordinates of the undistorted image points (or the CV_16UC1 map of initUndistortMapsCached()).
+ * @param outputFolder If not empty, the undistorted images are written to this folder under their original file name.
+ * @param display Show the original and the undistorted image side by side and wait for a key press.
+ * @return int The number of images that were read and, with an outputFolder, written; less than fileNames.size() on errors.
  */
-void undistortImages(const std::vector<std::string>& fileNames, const cv::Mat& mapX, const cv::Mat& mapY) {
+int undistortImages(const std::vector<std::string>& fileNames, const cv::Mat& mapX, const cv::Mat& mapY, const std::string& outputFolder, bool display) {
+    int undistortedCount = 0;
+
     for (const auto& fileName : fileNames) {
-        cv::Mat img = cv::imread(fileName);
+        cv::Mat img;
+        {
+            TELEMETRY_SCOPE("image decode");
+            img = cv::imread(fileName);
+        }
+        if (img.empty()) {
+            std::cerr << "Error: Cannot read " << fileName << std::endl;
+            continue;
+        }
+
         cv::Mat undistortedImg;
+        {
+            TELEMETRY_SCOPE("remap");
+            cv::remap(img, undistortedImg, mapX, mapY, cv::INTER_LINEAR);
+        }
+
+        if (!outputFolder.empty()) {
+            std::string baseName = fileName.substr(fileName.find_last_of("/\\") + 1);
+            std::string outputFileName = outputFolder + "/" + baseName;
+            if (!cv::imwrite(outputFileName, undistortedImg)) {
+                std::cerr << "Error: Cannot write " << outputFileName << std::endl;
+                continue;
+            }
+        }
 
-        cv::remap(img, undistortedImg, mapX, mapY, cv::INTER_LINEAR);
+        undistortedCount++;
 
-        // Join the images and display them side by side and reduce their size by half for display purposes.
-        cv::Mat combinedImg;
-        cv::hconcat(img, undistortedImg, combinedImg);
-        cv::resize(combinedImg, combinedImg, cv::Size(), 0.5, 0.5);
+        if (display) {
+            // Join the images and display them side by side and reduce their size by half for display purposes.
+            cv::Mat combinedImg;
+            cv::hconcat(img, undistortedImg, combinedImg);
+            cv::resize(combinedImg, combinedImg, cv::Size(), 0.5, 0.5);
 
-        cv::imshow("Correction Comparison", combinedImg);
-        cv::waitKey(0);
+            cv::imshow("Correction Comparison", combinedImg);
+            cv::waitKey(0);
+        }
     }
+
+    return undistortedCount;
 }
 
 
@@ -160,6 +733,109 @@ void initUndistortMaps(const cv::Matx33f& K, const cv::Vec<float, 5>& k, const c
 
 
 
+// Header of an undistortion map cache file. The key (K, k, frame size) decides whether the cached maps can be used.
+struct UndistortMapCacheHeader {
+    char magic[4];
+    uint32_t version;
+    float K[9];
+    float k[5];
+    int32_t width;
+    int32_t height;
+};
+
+static const char undistortMapCacheMagic[4] = { 'U', 'D', 'M', 'C' };
+static const uint32_t undistortMapCacheVersion = 1;
+
+static UndistortMapCacheHeader makeUndistortMapCacheHeader(const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize) {
+    UndistortMapCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, undistortMapCacheMagic, sizeof(header.magic));
+    header.version = undistortMapCacheVersion;
+    std::memcpy(header.K, K.val, sizeof(header.K));
+    std::memcpy(header.k, k.val, sizeof(header.k));
+    header.width = frameSize.width;
+    header.height = frameSize.height;
+    return header;
+}
+
+// Writes the raw pixels of a continuous map
+static void writeMapData(std::ofstream& file, const cv::Mat& map) {
+    CV_Assert(map.isContinuous());
+    file.write(reinterpret_cast<const char*>(map.data), static_cast<std::streamsize>(map.total() * map.elemSize()));
+}
+
+// Reads the raw pixels of a map whose size and type are known from the cache key
+static bool readMapData(std::ifstream& file, const cv::Size& size, int type, cv::Mat& map) {
+    map.create(size, type);
+    file.read(reinterpret_cast<char*>(map.data), static_cast<std::streamsize>(map.total() * map.elemSize()));
+    return static_cast<bool>(file);
+}
+
+
+/**
+ * @brief Initializes fixed point undistortion maps, reusing a cache file when it was built for the same calibration.
+ *
+ * The maps are stored in the compact CV_16SC2 + CV_16UC1 representation, which takes half the memory of two
+ * CV_32FC1 maps and is faster in cv::remap(). If the cache file exists and its key (K, k and frame size) matches
+ * exactly, the maps are read from it; otherwise they are computed and the cache file is (re)written. The new
+ * cache is written to a temporary file and renamed into place, so an interrupted write never leaves a
+ * truncated cache behind.
+ *
+ * @param K The intrinsic camera matrix.
+ * @param k The distortion coefficients.
+ * @param frameSize The size of the images used for calibration.
+ * @param cacheFileName The binary cache file to read from and write to.
+ * @param map1 The CV_16SC2 integer coordinates to be computed.
+ * @param map2 The CV_16UC1 interpolation table indices to be computed.
+ * @return UndistortMapCacheResult Loaded if the maps came from the cache, BuiltAndCached if they were computed and
+ *         the cache was written, BuiltNotCached if they were computed but the cache could not be written.
+ */
+UndistortMapCacheResult initUndistortMapsCached(const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize, const std::string& cacheFileName, cv::Mat& map1, cv::Mat& map2) {
+    const UndistortMapCacheHeader expected = makeUndistortMapCacheHeader(K, k, frameSize);
+
+    std::ifstream inFile(cacheFileName, std::ios::binary);
+    if (inFile) {
+        UndistortMapCacheHeader header;
+        inFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (inFile && std::memcmp(&header, &expected, sizeof(header)) == 0
+            && readMapData(inFile, frameSize, CV_16SC2, map1)
+            && readMapData(inFile, frameSize, CV_16UC1, map2)) {
+            return UndistortMapCacheResult::Loaded;
+        }
+    }
+    inFile.close();
+
+    cv::initUndistortRectifyMap(K, k, cv::Matx33f::eye(), K, frameSize, CV_16SC2, map1, map2);
+
+    const std::string tempFileName = cacheFileName + ".tmp";
+    std::ofstream outFile(tempFileName, std::ios::binary);
+    if (!outFile) {
+        std::cerr << "Error: Could not open " << tempFileName << " for caching the undistortion maps." << std::endl;
+        return UndistortMapCacheResult::BuiltNotCached;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(&expected), sizeof(expected));
+    writeMapData(outFile, map1);
+    writeMapData(outFile, map2);
+
+    outFile.close();
+    if (!outFile) {
+        std::cerr << "Error: Could not write the undistortion map cache " << tempFileName << std::endl;
+        std::remove(tempFileName.c_str());
+        return UndistortMapCacheResult::BuiltNotCached;
+    }
+
+    if (!replaceFileWith(cacheFileName, tempFileName)) {
+        std::cerr << "Error: Could not replace the undistortion map cache " << cacheFileName << std::endl;
+        return UndistortMapCacheResult::BuiltNotCached;
+    }
+
+    return UndistortMapCacheResult::BuiltAndCached;
+}
+
+
+
 /**
  * @brief Saves the camera calibration parameters to a file.
  * @param filename The name of the file to save the calibration parameters.
@@ -188,3 +864,174 @@ bool saveCameraCalibration(const std::string& filename, const cv::Matx33f& K, co
     outFile.close();
     return true;
 }
+
+
+// Binary calibration file layout: a header followed by one fixed size record per camera.
+// Everything is stored as 32 bit values in host byte order (little endian on x86 and ARM), so loading is a plain
+// memory copy; a file written on a machine of the other byte order fails the version check and is rejected.
+struct CalibrationFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t cameraCount;
+    uint32_t recordSize;
+};
+
+struct CalibrationFileRecord {
+    char name[32];
+    float K[9];
+    float k[5];
+    int32_t width;
+    int32_t height;
+};
+
+static const char calibrationFileMagic[4] = { 'C', 'V', 'C', 'B' };
+static const uint32_t calibrationFileVersion = 1;
+
+
+/**
+ * @brief Saves the calibrations of one or more cameras to a versioned binary file.
+ * @param filename The name of the binary file.
+ * @param cameras The camera calibrations; names longer than 31 characters are truncated.
+ * @return true if the calibrations were saved successfully, false otherwise.
+ */
+bool saveCameraCalibrationsBinary(const std::string& filename, const std::vector<CameraCalibration>& cameras) {
+    std::ofstream outFile(filename, std::ios::binary);
+
+    if (!outFile) {
+        std::cerr << "Error: Could not open file for saving camera calibration parameters." << std::endl;
+        return false;
+    }
+
+    CalibrationFileHeader header;
+    std::memcpy(header.magic, calibrationFileMagic, sizeof(header.magic));
+    header.version = calibrationFileVersion;
+    header.cameraCount = static_cast<uint32_t>(cameras.size());
+    header.recordSize = sizeof(CalibrationFileRecord);
+
+    std::vector<CalibrationFileRecord> records(cameras.size());
+    for (std::size_t i = 0; i < cameras.size(); i++) {
+        CalibrationFileRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        std::strncpy(record.name, cameras[i].name.c_str(), sizeof(record.name) - 1);
+        std::memcpy(record.K, cameras[i].K.val, sizeof(record.K));
+        std::memcpy(record.k, cameras[i].k.val, sizeof(record.k));
+        record.width = cameras[i].frameSize.width;
+        record.height = cameras[i].frameSize.height;
+    }
+
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outFile.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(CalibrationFileRecord)));
+
+    return static_cast<bool>(outFile);
+}
+
+
+/**
+ * @brief Loads all camera calibrations from a binary file written by saveCameraCalibrationsBinary().
+ *
+ * The whole file is read with a single call and the records are copied straight into the OpenCV types,
+ * there is no text parsing involved.
+ *
+ * @param filename The name of the binary file.
+ * @param cameras The loaded camera calibrations.
+ * @return true if the file was loaded successfully, false otherwise.
+ */
+bool loadCameraCalibrations(const std::string& filename, std::vector<CameraCalibration>& cameras) {
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+
+    if (!inFile) {
+        std::cerr << "Error: Could not open " << filename << " for loading camera calibration parameters." << std::endl;
+        return false;
+    }
+
+    std::vector<char> buffer(static_cast<std::size_t>(inFile.tellg()));
+    inFile.seekg(0);
+    inFile.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    CalibrationFileHeader header;
+    if (!inFile || buffer.size() < sizeof(header)) {
+        std::cerr << "Error: " << filename << " is not a camera calibration file." << std::endl;
+        return false;
+    }
+    std::memcpy(&header, buffer.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, calibrationFileMagic, sizeof(header.magic)) != 0
+        || header.version != calibrationFileVersion
+        || header.recordSize != sizeof(CalibrationFileRecord)
+        || buffer.size() < sizeof(header) + static_cast<std::size_t>(header.cameraCount) * sizeof(CalibrationFileRecord)) {
+        std::cerr << "Error: " << filename << " is not a supported camera calibration file." << std::endl;
+        return false;
+    }
+
+    const char* recordData = buffer.data() + sizeof(header);
+    cameras.resize(header.cameraCount);
+
+    for (uint32_t i = 0; i < header.cameraCount; i++) {
+        CalibrationFileRecord record;
+        std::memcpy(&record, recordData + i * sizeof(CalibrationFileRecord), sizeof(record));
+        record.name[sizeof(record.name) - 1] = '\0';
+
+        cameras[i].name = record.name;
+        std::memcpy(cameras[i].K.val, record.K, sizeof(record.K));
+        std::memcpy(cameras[i].k.val, record.k, sizeof(record.k));
+        cameras[i].frameSize = cv::Size(record.width, record.height);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Loads the calibration of one camera from a binary file.
+ * @param filename The name of the binary file.
+ * @param K The intrinsic camera matrix.
+ * @param k The distortion coefficients.
+ * @param frameSize The size of the images used for calibration.
+ * @param cameraIndex Index of the camera in the file.
+ * @return true if the camera was loaded successfully, false otherwise.
+ */
+bool loadCameraCalibration(const std::string& filename, cv::Matx33f& K, cv::Vec<float, 5>& k, cv::Size& frameSize, int cameraIndex) {
+    std::vector<CameraCalibration> cameras;
+    if (!loadCameraCalibrations(filename, cameras)) {
+        return false;
+    }
+
+    if (cameraIndex < 0 || cameraIndex >= static_cast<int>(cameras.size())) {
+        std::cerr << "Error: " << filename << " has no camera " << cameraIndex << "." << std::endl;
+        return false;
+    }
+
+    K = cameras[cameraIndex].K;
+    k = cameras[cameraIndex].k;
+    frameSize = cameras[cameraIndex].frameSize;
+    return true;
+}
+
+
+/**
+ * @brief Exports camera calibrations as human readable YAML using cv::FileStorage.
+ * @param filename The name of the YAML file.
+ * @param cameras The camera calibrations.
+ * @return true if the file was written successfully, false otherwise.
+ */
+bool exportCameraCalibrationsYAML(const std::string& filename, const std::vector<CameraCalibration>& cameras) {
+    cv::FileStorage fs(filename, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_YAML);
+
+    if (!fs.isOpened()) {
+        std::cerr << "Error: Could not open " << filename << " for exporting camera calibration parameters." << std::endl;
+        return false;
+    }
+
+    fs << "cameras" << "[";
+    for (const CameraCalibration& camera : cameras) {
+        fs << "{";
+        fs << "name" << camera.name;
+        fs << "K" << cv::Mat(camera.K);
+        fs << "k" << cv::Mat(camera.k);
+        fs << "frameSize" << camera.frameSize;
+        fs << "}";
+    }
+    fs << "]";
+
+    return true;
+}
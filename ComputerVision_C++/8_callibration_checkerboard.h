@@ -1,4 +1,26 @@
 #pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Checkerboard detection result of a single image
+struct CornerDetection {
+    std::string fileName;
+    bool patternFound = false;
+    std::vector<cv::Point2f> corners;
+    double detectionTimeMs = 0.0;
+    bool fromCache = false;
+};
+
+// Calibration of one camera as stored in a binary calibration file
+struct CameraCalibration {
+    std::string name;
+    cv::Matx33f K;
+    cv::Vec<float, 5> k;
+    cv::Size frameSize;
+};
 
 // Get image paths from a folder
 std::vector<std::string> getImagePathsFromFolder(const std::string& folderPath);
@@ -10,17 +32,91 @@ std::vector<cv::Point3f> generateWorldCoordinates(const int checkerboardSize[2])
 // Detect Corners in 2d plane
 std::vector<std::vector<cv::Point2f>> detectCorners(const std::vector<std::string>& fileNames, const cv::Size& patternSize, const int checkerboardDimensions[2], std::vector<std::vector<cv::Point3f>>& Q, bool displayDetectedPoints=false);
 
+// Detect checkerboard corners of all images in parallel, results are ordered like fileNames
+// downscaleFactor > 1 searches the pattern on a reduced image and refines the corners at full resolution
+std::vector<CornerDetection> detectCornersInImages(const std::vector<std::string>& fileNames, const cv::Size& patternSize, int downscaleFactor = 1);
+
+// Like detectCornersInImages(), but corners are cached on disk keyed by image content hash, board size and downscale factor;
+// only new or changed images are detected
+std::vector<CornerDetection> detectCornersInImagesCached(const std::vector<std::string>& fileNames, const cv::Size& patternSize, const std::string& cornerCacheFileName, int downscaleFactor = 1);
+
+// Detect Corners in parallel; only views where the pattern was found are returned, so Q and q stay aligned
+// with a cornerCacheFileName, corners of images seen before are taken from the corner cache
+std::vector<std::vector<cv::Point2f>> detectCornersParallel(const std::vector<std::string>& fileNames, const cv::Size& patternSize, const int checkerboardDimensions[2], std::vector<std::vector<cv::Point3f>>& Q, int downscaleFactor = 1, const std::string& cornerCacheFileName = "");
+
+
+// Calibrate camera and compute errors; useInitialGuess starts from the given K and k (warm start)
+float calibrateCameraAndComputeErrors(const std::vector<std::vector<cv::Point3f>>& Q, const std::vector<std::vector<cv::Point2f>>& q, const cv::Size& frameSize, cv::Matx33f& K, cv::Vec<float, 5>& k, bool useInitialGuess = false);
+
+
+// Camera calibration that grows view by view: added images are detected once (or taken from the corner cache)
+// and every calibrate() call is warm-started from the previous K and k.
+class IncrementalCalibration {
+public:
+    IncrementalCalibration(const cv::Size& patternSize, const int checkerboardDimensions[2], const cv::Size& frameSize, const std::string& cornerCacheFileName = "", int downscaleFactor = 1);
+
+    // start from a known calibration, e.g. one loaded with loadCameraCalibration()
+    void setInitialCalibration(const cv::Matx33f& K, const cv::Vec<float, 5>& k);
+
+    // add images; images already added with the same content are skipped. Returns the number of new usable views
+    int addImages(const std::vector<std::string>& fileNames);
+
+    // calibrate with all views, warm-started when a previous calibration exists; returns the reprojection error
+    float calibrate();
 
-// Calibrate camera and compute errors
-float calibrateCameraAndComputeErrors(const std::vector<std::vector<cv::Point3f>>& Q, const std::vector<std::vector<cv::Point2f>>& q, const cv::Size& frameSize, cv::Matx33f& K, cv::Vec<float, 5>& k);
+    const cv::Matx33f& K() const { return K_; }
+    const cv::Vec<float, 5>& k() const { return k_; }
+    const cv::Size& frameSize() const { return frameSize_; }
+    std::size_t numViews() const;
+    bool isCalibrated() const { return calibrated_; }
 
-// Undistort the images
-void undistortImages(const std::vector<std::string>& fileNames, const cv::Mat& mapX, const cv::Mat& mapY);
+private:
+    struct View {
+        uint64_t hash;
+        bool patternFound;
+        std::vector<cv::Point2f> corners;
+    };
+
+    cv::Size patternSize_;
+    std::vector<cv::Point3f> objectPoints_;
+    cv::Size frameSize_;
+    std::string cornerCacheFileName_;
+    int downscaleFactor_;
+
+    cv::Matx33f K_;
+    cv::Vec<float, 5> k_;
+    bool calibrated_ = false;
+
+    // every added image by file name, also those without the pattern so they are not detected again
+    std::map<std::string, View> views_;
+};
+
+// Undistort the images, optionally writing them to outputFolder; display shows each result and waits for a key.
+// Returns the number of images that were read and, with an outputFolder, written.
+int undistortImages(const std::vector<std::string>& fileNames, const cv::Mat& mapX, const cv::Mat& mapY, const std::string& outputFolder = "", bool display = true);
 
 
 // init undistort maps
 void initUndistortMaps(const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize, cv::Mat& mapX, cv::Mat& mapY);
 
+// Where the maps of initUndistortMapsCached() came from; the maps are valid in all three cases
+enum class UndistortMapCacheResult { Loaded, BuiltAndCached, BuiltNotCached };
+
+// init fixed point undistort maps (CV_16SC2 + CV_16UC1), loaded from a binary cache file when K, k and frameSize match
+UndistortMapCacheResult initUndistortMapsCached(const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize, const std::string& cacheFileName, cv::Mat& map1, cv::Mat& map2);
+
 
 // Save camera callibration to a file
-bool saveCameraCalibration(const std::string& filename, const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize);
\ No newline at end of file
+bool saveCameraCalibration(const std::string& filename, const cv::Matx33f& K, const cv::Vec<float, 5>& k, const cv::Size& frameSize);
+
+// Save the calibrations of one or more cameras to a versioned binary file
+bool saveCameraCalibrationsBinary(const std::string& filename, const std::vector<CameraCalibration>& cameras);
+
+// Load all camera calibrations from a binary file
+bool loadCameraCalibrations(const std::string& filename, std::vector<CameraCalibration>& cameras);
+
+// Load one camera calibration from a binary file
+bool loadCameraCalibration(const std::string& filename, cv::Matx33f& K, cv::Vec<float, 5>& k, cv::Size& frameSize, int cameraIndex = 0);
+
+// Export camera calibrations as human readable YAML
+bool exportCameraCalibrationsYAML(const std::string& filename, const std::vector<CameraCalibration>& cameras);
\ No newline at end of file
@@ -1,32 +1,258 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <climits>
 #include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include "1_load_images_videos_webcam.h"
+#include "3_resize_crop.h"
+#include "9_pose_tracking.h"
+#include "15_telemetry.h"
+
+
+// Fixed point precision used by OpenCV for the 8-bit BGR to HSV conversion.
+static const int hsvShift = 12;
+
+// Division tables of the 8-bit BGR to HSV conversion, identical to the ones cv::cvtColor uses,
+// so that the fused kernel produces exactly the same H, S and V values.
+struct HSVDivisionTables {
+    int saturation[256];
+    int hue[256];
+
+    HSVDivisionTables() {
+        saturation[0] = hue[0] = 0;
+        for (int i = 1; i < 256; i++) {
+            saturation[i] = cv::saturate_cast<int>((255 << hsvShift) / (1. * i));
+            hue[i] = cv::saturate_cast<int>((180 << hsvShift) / (6. * i));
+        }
+    }
+};
+
+static const HSVDivisionTables& hsvDivisionTables() {
+    static const HSVDivisionTables tables;
+    return tables;
+}
+
+// HSV bounds rounded the same way cv::inRange rounds scalar bounds for 8-bit images.
+struct HSVRange {
+    int lower[3];
+    int upper[3];
+    bool hueWraps;
+    bool empty;
+};
+
+static HSVRange makeHSVRange(const cv::Point3f& lower, const cv::Point3f& upper) {
+    HSVRange range;
+    const float lowerValues[3] = { lower.x, lower.y, lower.z };
+    const float upperValues[3] = { upper.x, upper.y, upper.z };
+
+    range.empty = false;
+    for (int c = 0; c < 3; c++) {
+        range.lower[c] = cvRound(lowerValues[c]);
+        range.upper[c] = cvRound(upperValues[c]);
+    }
+
+    // a hue range with lower > upper selects [lower, 179] and [0, upper]
+    range.hueWraps = range.lower[0] > range.upper[0];
+
+    for (int c = 0; c < 3; c++) {
+        bool inverted = range.lower[c] > range.upper[c] && !(c == 0 && range.hueWraps);
+        if (inverted || range.lower[c] > 255 || range.upper[c] < 0) {
+            range.empty = true;
+        }
+        range.lower[c] = std::max(range.lower[c], 0);
+        range.upper[c] = std::min(range.upper[c], 255);
+    }
+
+    return range;
+}
+
+// Converts one BGR pixel to HSV with the cv::cvtColor fixed point arithmetic and tests it against the range.
+// V and S are checked first because they are cheaper than H.
+static inline bool isInHSVRange(const HSVRange& range, const HSVDivisionTables& tables, int b, int g, int r) {
+    int v = std::max(b, std::max(g, r));
+    if (v < range.lower[2] || v > range.upper[2]) {
+        return false;
+    }
+
+    int diff = v - std::min(b, std::min(g, r));
+    int s = (diff * tables.saturation[v] + (1 << (hsvShift - 1))) >> hsvShift;
+    if (s < range.lower[1] || s > range.upper[1]) {
+        return false;
+    }
+
+    int vr = v == r ? -1 : 0;
+    int vg = v == g ? -1 : 0;
+    int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+    h = (h * tables.hue[diff] + (1 << (hsvShift - 1))) >> hsvShift;
+    h += h < 0 ? 180 : 0;
+
+    if (range.hueWraps) {
+        return h >= range.lower[0] || h <= range.upper[0];
+    }
+    return h >= range.lower[0] && h <= range.upper[0];
+}
+
+
+#if CV_SIMD
+// Zero-extends the 8-bit lanes of a vector into four vectors of 32-bit lanes, in lane order.
+static inline void expandToInt32(const cv::v_uint8& a, cv::v_int32 out[4]) {
+    cv::v_uint16 low, high;
+    cv::v_expand(a, low, high);
+
+    cv::v_uint32 q0, q1, q2, q3;
+    cv::v_expand(low, q0, q1);
+    cv::v_expand(high, q2, q3);
+
+    out[0] = cv::v_reinterpret_as_s32(q0);
+    out[1] = cv::v_reinterpret_as_s32(q1);
+    out[2] = cv::v_reinterpret_as_s32(q2);
+    out[3] = cv::v_reinterpret_as_s32(q3);
+}
+#endif
+
+
+// Thresholds one row of BGR pixels, writing 255 inside and 0 outside the range.
+// The vector loop computes H, S and V with the same fixed point arithmetic and division tables as the scalar
+// isInHSVRange() (and cv::cvtColor), in 32-bit lanes with table gathers; the remaining pixels use the scalar code.
+static void hsvRangeMaskRow(const uchar* src, uchar* dst, int width, const HSVRange& range, const HSVDivisionTables& tables) {
+    int x = 0;
+
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    const cv::v_int32 half = cv::vx_setall_s32(1 << (hsvShift - 1));
+    const cv::v_int32 hueRange = cv::vx_setall_s32(180);
+    const cv::v_int32 zero = cv::vx_setzero_s32();
+    const cv::v_int32 lowerH = cv::vx_setall_s32(range.lower[0]), upperH = cv::vx_setall_s32(range.upper[0]);
+    const cv::v_int32 lowerS = cv::vx_setall_s32(range.lower[1]), upperS = cv::vx_setall_s32(range.upper[1]);
+    const cv::v_int32 lowerV = cv::vx_setall_s32(range.lower[2]), upperV = cv::vx_setall_s32(range.upper[2]);
+
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_uint8 b8, g8, r8;
+        cv::v_load_deinterleave(src + 3 * x, b8, g8, r8);
+
+        cv::v_int32 blue[4], green[4], red[4], inside[4];
+        expandToInt32(b8, blue);
+        expandToInt32(g8, green);
+        expandToInt32(r8, red);
+
+        for (int k = 0; k < 4; k++) {
+            const cv::v_int32 b = blue[k], g = green[k], r = red[k];
+
+            cv::v_int32 v = cv::v_max(b, cv::v_max(g, r));
+            cv::v_int32 diff = v - cv::v_min(b, cv::v_min(g, r));
+            cv::v_int32 s = (diff * cv::v_lut(tables.saturation, v) + half) >> hsvShift;
+
+            cv::v_int32 vr = v == r;
+            cv::v_int32 vg = v == g;
+            cv::v_int32 h = (vr & (g - b)) + (~vr & ((vg & (b - r + (diff << 1))) + (~vg & (r - g + (diff << 2)))));
+            h = (h * cv::v_lut(tables.hue, diff) + half) >> hsvShift;
+            h = h + ((h < zero) & hueRange);
+
+            cv::v_int32 hueInside = range.hueWraps ? ((h >= lowerH) | (h <= upperH)) : ((h >= lowerH) & (h <= upperH));
+            inside[k] = hueInside & (s >= lowerS) & (s <= upperS) & (v >= lowerV) & (v <= upperV);
+        }
+
+        // all-ones / zero 32-bit lanes saturate to 0xFF / 0x00 bytes
+        cv::v_int16 low = cv::v_pack(inside[0], inside[1]);
+        cv::v_int16 high = cv::v_pack(inside[2], inside[3]);
+        cv::v_store(dst + x, cv::v_reinterpret_as_u8(cv::v_pack(low, high)));
+    }
+    cv::vx_cleanup();
+#endif
+
+    for (src += 3 * x; x < width; x++, src += 3) {
+        dst[x] = isInHSVRange(range, tables, src[0], src[1], src[2]) ? 255 : 0;
+    }
+}
 
 
 /**
  * @brief Applies a range-based color mask on an input BGR image.
  *
+ * 8-bit BGR images go through applyColorMaskFused(), other depths through cv::cvtColor and cv::inRange.
+ * In both cases a hue range with lower.x > upper.x wraps around 179 -> 0.
+ *
  * @param bgrImage The input BGR image to be processed.
  * @param lower The lower bound for the range in the HSV color space (as cv::Point3f).
  * @param upper The upper bound for the range in the HSV color space (as cv::Point3f).
  * @return cv::Mat The processed image with a color mask applied.
  */
 cv::Mat applyColorMask(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper) {
+    cv::Mat mask;
+
+    if (bgrImage.type() == CV_8UC3) {
+        applyColorMaskFused(bgrImage, lower, upper, mask);
+        return mask;
+    }
+
     // Convert BGR image to HSV
     cv::Mat hsvImage;
-    cv::cvtColor(bgrImage, hsvImage, cv::COLOR_BGR2HSV);
+    {
+        TELEMETRY_SCOPE("color conversion");
+        cv::cvtColor(bgrImage, hsvImage, cv::COLOR_BGR2HSV);
+    }
 
     cv::Scalar lowerBound(lower.x, lower.y, lower.z);
     cv::Scalar upperBound(upper.x, upper.y, upper.z);
 
     // Detect the color
-    cv::Mat mask;
-    cv::inRange(hsvImage, lowerBound, upperBound, mask);
+    {
+        TELEMETRY_SCOPE("threshold");
+        if (lower.x > upper.x) {
+            // wrapping hue: [lower.x, max hue] or [0, upper.x]
+            double maxHue = hsvImage.depth() == CV_32F ? 360.0 : 255.0;
+            cv::Mat upperPart;
+            cv::inRange(hsvImage, lowerBound, cv::Scalar(maxHue, upper.y, upper.z), mask);
+            cv::inRange(hsvImage, cv::Scalar(0, lower.y, lower.z), upperBound, upperPart);
+            cv::bitwise_or(mask, upperPart, mask);
+        }
+        else {
+            cv::inRange(hsvImage, lowerBound, upperBound, mask);
+        }
+    }
 
     return mask;
 }
 
 
+/**
+ * @brief Applies a range-based HSV color mask on an 8-bit BGR image in a single pass.
+ *
+ * Pixels are converted to HSV and thresholded in SIMD registers (OpenCV universal intrinsics), so no
+ * intermediate HSV image is allocated and every pixel is read once. The result is bit-identical to
+ * cv::cvtColor(COLOR_BGR2HSV) followed by cv::inRange. If lower.x > upper.x the hue range wraps around
+ * 179 -> 0, which selects red objects in one call. Rows are processed in parallel and the mask buffer
+ * is reused when it already has the right size and type.
+ *
+ * @param bgrImage The input CV_8UC3 BGR image.
+ * @param lower The lower bound for the range in the HSV color space (as cv::Point3f).
+ * @param upper The upper bound for the range in the HSV color space (as cv::Point3f).
+ * @param mask The output CV_8UC1 mask (255 inside the range, 0 outside).
+ */
+void applyColorMaskFused(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper, cv::Mat& mask) {
+    CV_Assert(bgrImage.type() == CV_8UC3);
+    TELEMETRY_SCOPE("color conversion + threshold (fused)");
+
+    mask.create(bgrImage.size(), CV_8UC1);
+
+    const HSVRange range = makeHSVRange(lower, upper);
+    if (range.empty) {
+        mask.setTo(cv::Scalar(0));
+        return;
+    }
+
+    const HSVDivisionTables& tables = hsvDivisionTables();
+    const int width = bgrImage.cols;
+
+    cv::parallel_for_(cv::Range(0, bgrImage.rows), [&](const cv::Range& rows) {
+        for (int y = rows.start; y < rows.end; y++) {
+            hsvRangeMaskRow(bgrImage.ptr<uchar>(y), mask.ptr<uchar>(y), width, range, tables);
+        }
+    });
+}
+
+
 /**
  * @brief Generates masked images for all frames based on a given HSV color range.
  *
@@ -45,11 +271,11 @@ std::vector<cv::Mat> generateMaskedImages(const std::vector<cv::Mat>& frames, co
 
 
 // save vector to a text file
-void saveVectorToFile(const std::vector<cv::Point2f> pointVector, const std::string& fileName) {
+void saveVectorToFile(const std::vector<cv::Point2f>& pointVector, const std::string& fileName) {
 	std::ofstream file(fileName);
     if (file.is_open()) {
         for (const auto& point : pointVector) {
-			file << point.x << "," << point.y << std::endl;
+			file << point.x << "," << point.y << "\n";
 		}
 		file.close();
 	}
@@ -62,6 +288,8 @@ void saveVectorToFile(const std::vector<cv::Point2f> pointVector, const std::str
  * @return cv::Point2f The 2D position of the object.
  */
 cv::Point2f findObjectPosition(const cv::Mat& frame) {
+    TELEMETRY_SCOPE("moments");
+
     // Calculate moments of the binary image
     cv::Moments m = cv::moments(frame, true);
 
@@ -75,4 +303,309 @@ cv::Point2f findObjectPosition(const cv::Mat& frame) {
     float y = static_cast<float>(m.m01 / m.m00);
 
     return cv::Point2f(x, y);
+}
+
+
+/**
+ * @brief Finds the 2D position of an object directly from a BGR frame and an HSV color range.
+ *
+ * Equivalent to findObjectPosition(applyColorMask(bgrImage, lower, upper)), but no frame-sized mask is
+ * written: each row is thresholded with the vectorized kernel into a one-row buffer and the pixel count
+ * and x/y sums are accumulated from it right away. The frame is split into row bands that are processed
+ * in parallel, each with its own row buffer and partial sums which are added up at the end.
+ *
+ * @param bgrImage The input CV_8UC3 BGR frame.
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param boundingBox If not null, receives the bounding box of the in-range pixels (like cv::boundingRect() of
+ *        the mask), or an empty rectangle if no pixel is in range.
+ * @return cv::Point2f The 2D position of the object, or (-1, -1) if no pixel is in range.
+ */
+cv::Point2f findObjectPositionInColorRange(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper, cv::Rect* boundingBox) {
+    if (boundingBox != nullptr) {
+        *boundingBox = cv::Rect();
+    }
+
+    // an empty frame has no object, like findObjectPosition() of an empty mask
+    if (bgrImage.empty()) {
+        return cv::Point2f(-1, -1);
+    }
+
+    CV_Assert(bgrImage.type() == CV_8UC3);
+    TELEMETRY_SCOPE("threshold + moments (fused)");
+
+    const HSVRange range = makeHSVRange(lower, upper);
+    if (range.empty) {
+        return cv::Point2f(-1, -1);
+    }
+
+    struct PartialMoments {
+        int64 count = 0;
+        int64 sumX = 0;
+        int64 sumY = 0;
+        int minX = INT_MAX;
+        int minY = INT_MAX;
+        int maxX = -1;
+        int maxY = -1;
+    };
+
+    const HSVDivisionTables& tables = hsvDivisionTables();
+    const int width = bgrImage.cols;
+    const int numBands = std::min(bgrImage.rows, std::max(1, cv::getNumThreads()) * 4);
+    std::vector<PartialMoments> partials(numBands);
+
+    cv::parallel_for_(cv::Range(0, numBands), [&](const cv::Range& bands) {
+        for (int band = bands.start; band < bands.end; band++) {
+            int rowStart = static_cast<int>(static_cast<int64>(bgrImage.rows) * band / numBands);
+            int rowEnd = static_cast<int>(static_cast<int64>(bgrImage.rows) * (band + 1) / numBands);
+            PartialMoments sums;
+            std::vector<uchar> rowMask(width);
+
+            for (int y = rowStart; y < rowEnd; y++) {
+                hsvRangeMaskRow(bgrImage.ptr<uchar>(y), rowMask.data(), width, range, tables);
+                int64 rowCount = 0;
+                int64 rowSumX = 0;
+
+                // branchless: mask bytes are 0 or 255
+                for (int x = 0; x < width; x++) {
+                    int bit = rowMask[x] & 1;
+                    rowCount += bit;
+                    rowSumX += bit * x;
+                }
+
+                sums.count += rowCount;
+                sums.sumX += rowSumX;
+                sums.sumY += rowCount * y;
+
+                // the extent is only needed for the bounding box, and only rows with pixels can change it
+                if (boundingBox != nullptr && rowCount > 0) {
+                    int first = 0;
+                    while (rowMask[first] == 0) {
+                        first++;
+                    }
+                    int last = width - 1;
+                    while (rowMask[last] == 0) {
+                        last--;
+                    }
+
+                    sums.minX = std::min(sums.minX, first);
+                    sums.maxX = std::max(sums.maxX, last);
+                    sums.minY = std::min(sums.minY, y);
+                    sums.maxY = y;
+                }
+            }
+
+            partials[band] = sums;
+        }
+    });
+
+    PartialMoments total;
+    for (const PartialMoments& sums : partials) {
+        total.count += sums.count;
+        total.sumX += sums.sumX;
+        total.sumY += sums.sumY;
+        total.minX = std::min(total.minX, sums.minX);
+        total.minY = std::min(total.minY, sums.minY);
+        total.maxX = std::max(total.maxX, sums.maxX);
+        total.maxY = std::max(total.maxY, sums.maxY);
+    }
+
+    // Check for division by zero
+    if (total.count == 0) {
+        return cv::Point2f(-1, -1);
+    }
+
+    // Same centroid as findObjectPosition(): m10 / m00 and m01 / m00
+    float x = static_cast<float>(static_cast<double>(total.sumX) / static_cast<double>(total.count));
+    float y = static_cast<float>(static_cast<double>(total.sumY) / static_cast<double>(total.count));
+
+    if (boundingBox != nullptr) {
+        *boundingBox = cv::Rect(cv::Point(total.minX, total.minY), cv::Point(total.maxX + 1, total.maxY + 1));
+    }
+
+    return cv::Point2f(x, y);
+}
+
+
+/**
+ * @brief Tracks an object in a video stream one frame at a time.
+ *
+ * Each frame is decoded, masked and reduced to a position before the next one is read, so only a single
+ * frame and a single mask are alive at any time regardless of the length of the video. Works the same for
+ * video files and camera sources.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param onPosition Called with the frame index and the object position for every frame; return false to stop.
+ * @return int The number of frames processed, or -1 if the video is not opened.
+ */
+int trackObjectPositionsStreaming(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::function<bool(int, const cv::Point2f&)>& onPosition) {
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source." << std::endl;
+        return -1;
+    }
+
+    // reused for every frame so memory stays bounded; the mask is only needed for non 8-bit frames
+    cv::Mat frame;
+    cv::Mat mask;
+    int frameIndex = 0;
+
+    while (readFrame(video, frame)) {
+        cv::Point2f position;
+        if (frame.type() == CV_8UC3) {
+            position = findObjectPositionInColorRange(frame, lower, upper);
+        }
+        else {
+            mask = applyColorMask(frame, lower, upper);
+            position = findObjectPosition(mask);
+        }
+
+        bool keepGoing = onPosition(frameIndex, position);
+        frameIndex++;
+
+        if (!keepGoing) {
+            break;
+        }
+    }
+
+    return frameIndex;
+}
+
+
+/**
+ * @brief Tracks an object in a video stream and writes every position to a text file as it is found.
+ *
+ * The file has the same "x,y" per line format as saveVectorToFile(), but lines are written while the
+ * video is decoded instead of once at the end.
+ *
+ * @param video An opened video capture (file or camera).
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param fileName The text file to write the positions to.
+ * @return int The number of frames processed, or -1 on error.
+ */
+int trackObjectPositionsToFile(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName) {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return -1;
+    }
+
+    return trackObjectPositionsStreaming(video, lower, upper, [&file](int, const cv::Point2f& position) {
+        file << position.x << "," << position.y << "\n";
+        return true;
+    });
+}
+
+
+/**
+ * @brief Creates a tracker for an object within the given HSV color range.
+ *
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param windowSize Side length in pixels of the search window while the object is tracked; should be larger than the object.
+ * @param maxMisses Number of consecutive frames the object may be missed before a full frame search is done.
+ */
+PredictiveColorTracker::PredictiveColorTracker(const cv::Point3f& lower, const cv::Point3f& upper, int windowSize, int maxMisses)
+    : lower_(lower), upper_(upper), windowSize_(std::max(windowSize, 8)), maxMisses_(std::max(maxMisses, 0)) {
+}
+
+
+// forget the tracking history so the next frame is searched in full
+void PredictiveColorTracker::reset() {
+    tracking_ = false;
+    misses_ = 0;
+    numPositions_ = 0;
+    velocity_ = cv::Point2f(0, 0);
+}
+
+
+// constant velocity prediction from the last two centroids
+cv::Point2f PredictiveColorTracker::predictedPosition() const {
+    if (!tracking_) {
+        return cv::Point2f(-1, -1);
+    }
+    return lastPosition_ + velocity_;
+}
+
+
+// search window centered on a position, grown by the current speed and doubled for every missed frame
+cv::Rect PredictiveColorTracker::searchWindowAround(const cv::Point2f& center, const cv::Size& frameSize) const {
+    float speedMargin = std::abs(velocity_.x) + std::abs(velocity_.y);
+    float halfSize = (windowSize_ / 2.0f + speedMargin) * static_cast<float>(1 << std::min(misses_, 8));
+
+    cv::Rect window(cvFloor(center.x - halfSize), cvFloor(center.y - halfSize), cvCeil(2 * halfSize), cvCeil(2 * halfSize));
+    return window & cv::Rect(cv::Point(0, 0), frameSize);
+}
+
+
+// threshold only the pixels of the window (a view, no copy) and return the centroid in frame coordinates
+cv::Point2f PredictiveColorTracker::searchInWindow(const cv::Mat& bgrFrame, const cv::Rect& window) {
+    lastSearchWindow_ = window;
+    if (window.empty()) {
+        return cv::Point2f(-1, -1);
+    }
+
+    cv::Point2f position = findObjectPositionInColorRange(cropImage(bgrFrame, window), lower_, upper_);
+    if (position.x < 0) {
+        return position;
+    }
+    return position + cv::Point2f(static_cast<float>(window.x), static_cast<float>(window.y));
+}
+
+
+void PredictiveColorTracker::updateHistory(const cv::Point2f& position) {
+    velocity_ = numPositions_ > 0 ? position - lastPosition_ : cv::Point2f(0, 0);
+    lastPosition_ = position;
+    numPositions_++;
+    tracking_ = true;
+    misses_ = 0;
+}
+
+
+/**
+ * @brief Finds the object in the next frame, searching only around the predicted position while tracking.
+ *
+ * While the object is tracked, only a window around the constant velocity prediction is thresholded.
+ * On a miss the position coasts along the prediction and the window doubles for the next frame; after
+ * more than maxMisses consecutive misses the object is considered lost and the whole frame is searched.
+ *
+ * @param bgrFrame The next CV_8UC3 BGR frame.
+ * @return cv::Point2f The 2D position of the object, or (-1, -1) if it was not found in this frame.
+ */
+cv::Point2f PredictiveColorTracker::track(const cv::Mat& bgrFrame) {
+    const cv::Rect fullFrame(cv::Point(0, 0), bgrFrame.size());
+
+    if (tracking_) {
+        cv::Point2f prediction = predictedPosition();
+        cv::Point2f position = searchInWindow(bgrFrame, searchWindowAround(prediction, bgrFrame.size()));
+
+        if (position.x >= 0) {
+            updateHistory(position);
+            return position;
+        }
+
+        // the window already covered the whole frame, so there is nothing left to search
+        if (lastSearchWindow_ == fullFrame) {
+            reset();
+            return cv::Point2f(-1, -1);
+        }
+
+        // coast along the prediction and widen the window for the next frame
+        lastPosition_ = prediction;
+        misses_++;
+        if (misses_ <= maxMisses_) {
+            return cv::Point2f(-1, -1);
+        }
+
+        // the object is lost
+        reset();
+    }
+
+    cv::Point2f position = searchInWindow(bgrFrame, fullFrame);
+    if (position.x >= 0) {
+        updateHistory(position);
+    }
+    return position;
 }
\ No newline at end of file
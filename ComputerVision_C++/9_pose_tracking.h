@@ -1,14 +1,63 @@
 #pragma once
+#include <functional>
 #include <opencv2/opencv.hpp>
 
 // apply color mask based on HSV color range: lower and upper
 cv::Mat applyColorMask(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper);
 
+// apply color mask in a single vectorized pass over a BGR image, writing into a reusable mask; hue wraps around 179->0 when lower.x > upper.x
+void applyColorMaskFused(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper, cv::Mat& mask);
+
 // generate masked images for all frames based on a given HSV color range
 std::vector<cv::Mat> generateMaskedImages(const std::vector<cv::Mat>& frames, const cv::Point3f& lower, const cv::Point3f& upper);
 
 // save vector to a text file
-void saveVectorToFile(const std::vector<cv::Point2f> pointVector, const std::string& fileName);
+void saveVectorToFile(const std::vector<cv::Point2f>& pointVector, const std::string& fileName);
 
 // find the 2D position of an object in a binary frame
-cv::Point2f findObjectPosition(const cv::Mat& frame);
\ No newline at end of file
+cv::Point2f findObjectPosition(const cv::Mat& frame);
+
+// find the 2D position (and optionally the bounding box) of an object directly from a BGR frame and an HSV color range, without building a mask
+cv::Point2f findObjectPositionInColorRange(const cv::Mat& bgrImage, const cv::Point3f& lower, const cv::Point3f& upper, cv::Rect* boundingBox = nullptr);
+
+// track an object frame by frame from a video file or camera, reporting each position as soon as it is found
+int trackObjectPositionsStreaming(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::function<bool(int, const cv::Point2f&)>& onPosition);
+
+// track an object frame by frame and append every position to a text file while decoding
+int trackObjectPositionsToFile(cv::VideoCapture& video, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& fileName);
+
+
+// Tracks a colored object frame to frame by searching only a window around the position predicted from the
+// previous centroids. The window grows on misses and the search falls back to the full frame once the object is lost.
+class PredictiveColorTracker {
+public:
+    PredictiveColorTracker(const cv::Point3f& lower, const cv::Point3f& upper, int windowSize = 96, int maxMisses = 3);
+
+    // find the object in the next BGR frame; returns (-1, -1) when it is not found
+    cv::Point2f track(const cv::Mat& bgrFrame);
+
+    // forget the tracking history so the next frame is searched in full
+    void reset();
+
+    bool isTracking() const { return tracking_; }
+    cv::Point2f predictedPosition() const;
+    cv::Rect lastSearchWindow() const { return lastSearchWindow_; }
+    int64 lastPixelsSearched() const { return static_cast<int64>(lastSearchWindow_.area()); }
+
+private:
+    cv::Rect searchWindowAround(const cv::Point2f& center, const cv::Size& frameSize) const;
+    cv::Point2f searchInWindow(const cv::Mat& bgrFrame, const cv::Rect& window);
+    void updateHistory(const cv::Point2f& position);
+
+    cv::Point3f lower_;
+    cv::Point3f upper_;
+    int windowSize_;
+    int maxMisses_;
+
+    bool tracking_ = false;
+    int misses_ = 0;
+    int numPositions_ = 0;
+    cv::Point2f lastPosition_;
+    cv::Point2f velocity_;
+    cv::Rect lastSearchWindow_;
+};
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
@@ -34,25 +35,48 @@ void checkboardCameraCalib() {
     cv::Size patternSize(25 - 1, 18 - 1);
     int checkerboardDimensions[2] = { 25, 18 };
 
-    // Detect and refine corners
-    std::vector<std::vector<cv::Point3f>> Q;
-    std::vector<std::vector<cv::Point2f>> q = detectCorners(fileNames, patternSize, checkerboardDimensions, Q);
+    // Detect corners on half resolution images and refine them at full resolution; images already detected
+    // in an earlier run are taken from the corner cache, so only new or changed images are processed
+    cv::Size frameSize(1440, 1080);
+    int downscaleFactor = 2;
+    IncrementalCalibration calibration(patternSize, checkerboardDimensions, frameSize, "checkerboard_corners.cache", downscaleFactor);
 
-    // Calibrate the camera and compute errors
+    // Warm start from the previous calibration if there is one
+    std::string binaryFilename = "camera_calibration_checkerboard.bin";
     cv::Matx33f K(cv::Matx33f::eye());
     cv::Vec<float, 5> k(0, 0, 0, 0, 0);
-    cv::Size frameSize(1440, 1080);
-    float error = calibrateCameraAndComputeErrors(Q, q, frameSize, K, k);
+    cv::Size previousFrameSize;
+    if (std::ifstream(binaryFilename).good() && loadCameraCalibration(binaryFilename, K, k, previousFrameSize) && previousFrameSize == frameSize) {
+        calibration.setInitialCalibration(K, k);
+        std::cout << "Starting from the calibration in " << binaryFilename << std::endl;
+    }
+
+    calibration.addImages(fileNames);
+
+    // Calibrate the camera and compute errors
+    float error = calibration.calibrate();
+    if (error < 0) {
+        return;
+    }
+    K = calibration.K();
+    k = calibration.k();
 
     // Print the results
     std::cout << "Reprojection error = " << error << "\nK =\n"
         << K << "\nk=\n"
         << k << std::endl;
 
-    // Undistort the images
-    cv::Mat mapX, mapY;
-    initUndistortMaps(K, k, frameSize, mapX, mapY);
-    undistortImages(fileNames, mapX, mapY);
+    // Undistort the images with fixed point maps, reused from the cache when the calibration did not change
+    cv::Mat map1, map2;
+    std::string undistortMapCacheFilename = "undistort_maps_checkerboard.bin";
+    UndistortMapCacheResult cacheResult = initUndistortMapsCached(K, k, frameSize, undistortMapCacheFilename, map1, map2);
+    if (cacheResult == UndistortMapCacheResult::Loaded) {
+        std::cout << "Undistortion maps loaded from " << undistortMapCacheFilename << std::endl;
+    }
+    else if (cacheResult == UndistortMapCacheResult::BuiltAndCached) {
+        std::cout << "Undistortion maps saved to " << undistortMapCacheFilename << std::endl;
+    }
+    undistortImages(fileNames, map1, map2);
 
     // Save the camera calibration
     std::string outputFilename = "camera_calibration_checkerboard.txt";
@@ -64,5 +88,15 @@ void checkboardCameraCalib() {
         std::cerr << "Error: Unable to save camera calibration parameters." << std::endl;
     }
 
+    // Save the camera calibration in the binary format that loadCameraCalibration() reads
+    std::vector<CameraCalibration> cameras = { { "checkerboard", K, k, frameSize } };
+
+    if (saveCameraCalibrationsBinary(binaryFilename, cameras)) {
+        std::cout << "Camera calibration parameters saved to " << binaryFilename << std::endl;
+    }
+    else {
+        std::cerr << "Error: Unable to save camera calibration parameters." << std::endl;
+    }
+
 }
 
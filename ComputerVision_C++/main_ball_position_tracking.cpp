@@ -6,53 +6,49 @@
 #include <opencv2/highgui.hpp>
 
 #include "1_load_images_videos_webcam.h"
+#include "3_resize_crop.h"
 #include "6_color_detection.h"
 #include "9_pose_tracking.h"
+#include "12_kalman_tracking.h"
 
 
 int main() {
 
 	std::string ballVideoPath = "Resources/ball.mp4";
 
-	// load video frames
-	std::vector<cv::Mat> ballVideoFrames = loadVideoFrames(ballVideoPath);
-
-	//// display video frames
-	//displayVideoFrames(ballVideoFrames, "Ball Video");
+	// open the video; frames are decoded one at a time instead of loading the whole file
+	cv::VideoCapture ballVideo(ballVideoPath);
+	if (!ballVideo.isOpened()) {
+		std::cerr << "Error: Cannot open " << ballVideoPath << std::endl;
+		return -1;
+	}
 
 	// detect the ball using color detection by using just the first frame
-	cv::Mat ballFrame = ballVideoFrames[0];
-
-	// resize the frame to half its size
-	cv::resize(ballFrame, ballFrame, cv::Size(), 0.5, 0.5);
+	cv::Mat ballFrame;
+	ballVideo.read(ballFrame);
 
 	// detect the ball using HSV color detection
 	// do this when you want to find the HSV color range for the ball
 	// comment it out after finding out the lower and upper HSV color range
-	/*interactiveHSVColorRangeSelection(ballFrame);*/
+	/*interactiveHSVColorRangeSelection(scaleImage(ballFrame, 0.5, 0.5));*/
+	// or tune across frames sampled from the whole video, to cover changes in lighting
+	/*cv::Point3f tunedLower, tunedUpper;
+	interactiveHSVColorRangeSelection(sampleVideoFrames(ballVideo, 8), tunedLower, tunedUpper);*/
 
 	// following values were found using interactiveHSVColorRangeSelection
 	cv::Point3f lower(0, 108, 150);		// Hue, Saturation, Value
 	cv::Point3f upper(179, 255, 255);	// Hue, Saturation, 
 
-	// generate masked images for all frames based on a given HSV color range
-	std::vector<cv::Mat> maskedFrames = generateMaskedImages(ballVideoFrames, lower, upper);
-
-	// iterate over all masked frames to find the ball position and append to a vector
-	std::vector<cv::Point2f> ballPositions;
+	// rewind so that the first frame is tracked as well
+	ballVideo.set(cv::CAP_PROP_POS_FRAMES, 0);
 
-	for (const cv::Mat& maskedFrame : maskedFrames) {
-
-		// find the ball position in the masked frame
-		cv::Point2f ballPosition = findObjectPosition(maskedFrame);
-		
-		// append the ball position to the vector
-		ballPositions.push_back(ballPosition);
-	}
-
-	// save ball positions to a file
+	// track the ball frame by frame and write each position to the file as soon as it is found;
+	// a Kalman filter smooths the positions, fills frames where the ball is missed and narrows the search
+	// use trackObjectPositionsToFile instead to save the raw centroids
 	std::string ballPositionsFilePath = "Resources/ball_positions.txt";
-	saveVectorToFile(ballPositions, ballPositionsFilePath);
+	int frameCount = trackObjectPositionsFiltered(ballVideo, lower, upper, ballPositionsFilePath);
+
+	std::cout << "Tracked " << frameCount << " frames" << std::endl;
 
 
 	return 0;
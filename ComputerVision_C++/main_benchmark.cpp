@@ -0,0 +1,590 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "1_load_images_videos_webcam.h"
+#include "2_basic_functions.h"
+#include "3_resize_crop.h"
+#include "4_draw_write.h"
+#include "5_warping.h"
+#include "6_color_detection.h"
+#include "7_shape_contour_detection.h"
+#include "8_callibration_checkerboard.h"
+#include "9_pose_tracking.h"
+#include "10_pipeline_tracking.h"
+#include "12_kalman_tracking.h"
+
+
+// Timing statistics of one function at one resolution
+struct BenchmarkResult {
+    std::string name;
+    std::string resolution;
+    cv::Size size;
+    int iterations = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    double megapixelsPerSecond = 0.0;
+};
+
+// Command line options of the benchmark
+struct BenchmarkOptions {
+    std::string jsonFileName;
+    std::string filter;
+    int maxIterations = 200;
+    double minSecondsPerCase = 0.5;
+};
+
+
+static double percentile(const std::vector<double>& sortedValues, double p) {
+    if (sortedValues.empty()) {
+        return 0.0;
+    }
+    std::size_t index = static_cast<std::size_t>(p * (sortedValues.size() - 1) + 0.5);
+    return sortedValues[std::min(index, sortedValues.size() - 1)];
+}
+
+
+/**
+ * @brief Runs a function repeatedly and collects latency percentiles and throughput.
+ *
+ * The function is run once to warm up, then until either maxIterations runs or minSecondsPerCase
+ * seconds have passed (at least 3 runs).
+ *
+ * @param name The name of the benchmarked function.
+ * @param resolution The name of the resolution, e.g. "1080p".
+ * @param size The size of the processed image, used for the megapixels/s figure.
+ * @param options The benchmark options.
+ * @param fn The function to benchmark.
+ * @return BenchmarkResult The timing statistics.
+ */
+static BenchmarkResult runBenchmark(const std::string& name, const std::string& resolution, const cv::Size& size, const BenchmarkOptions& options, const std::function<void()>& fn) {
+    BenchmarkResult result;
+    result.name = name;
+    result.resolution = resolution;
+    result.size = size;
+
+    // warm up
+    fn();
+
+    std::vector<double> timesMs;
+    double totalMs = 0.0;
+    const double tickToMs = 1000.0 / cv::getTickFrequency();
+
+    while (static_cast<int>(timesMs.size()) < options.maxIterations
+        && (timesMs.size() < 3 || totalMs < options.minSecondsPerCase * 1000.0)) {
+        int64 start = cv::getTickCount();
+        fn();
+        double elapsedMs = (cv::getTickCount() - start) * tickToMs;
+
+        timesMs.push_back(elapsedMs);
+        totalMs += elapsedMs;
+    }
+
+    std::sort(timesMs.begin(), timesMs.end());
+
+    result.iterations = static_cast<int>(timesMs.size());
+    result.meanMs = totalMs / timesMs.size();
+    result.p50Ms = percentile(timesMs, 0.50);
+    result.p90Ms = percentile(timesMs, 0.90);
+    result.p99Ms = percentile(timesMs, 0.99);
+    result.maxMs = timesMs.back();
+    result.megapixelsPerSecond = result.meanMs > 0.0 ? (size.area() / 1.0e6) / (result.meanMs / 1000.0) : 0.0;
+
+    return result;
+}
+
+
+// Prints how much faster the candidate case ran than the reference case at one resolution, if both were run
+static void printSpeedup(const std::vector<BenchmarkResult>& results, const std::string& resolution, const std::string& reference, const std::string& candidate) {
+    const BenchmarkResult* referenceResult = nullptr;
+    const BenchmarkResult* candidateResult = nullptr;
+    for (const BenchmarkResult& result : results) {
+        if (result.resolution != resolution) {
+            continue;
+        }
+        if (result.name == reference) {
+            referenceResult = &result;
+        }
+        if (result.name == candidate) {
+            candidateResult = &result;
+        }
+    }
+
+    if (referenceResult == nullptr || candidateResult == nullptr || candidateResult->meanMs <= 0.0) {
+        return;
+    }
+
+    std::printf("%-38s %-6s %.2fx vs %s\n", candidate.c_str(), resolution.c_str(), referenceResult->meanMs / candidateResult->meanMs, reference.c_str());
+}
+
+
+// Synthetic BGR frame: noise plus an orange ball, so color masks and contours have something to find
+static cv::Mat createSyntheticFrame(const cv::Size& size) {
+    cv::Mat frame(size, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(120));
+
+    int radius = std::max(4, size.height / 20);
+    cv::circle(frame, cv::Point(size.width / 3, size.height / 2), radius, cv::Scalar(0, 140, 255), cv::FILLED);
+    cv::rectangle(frame, cv::Rect(size.width / 2, size.height / 4, size.width / 5, size.height / 3), cv::Scalar(255, 255, 255), 3);
+
+    return frame;
+}
+
+
+// Synthetic checkerboard with the given number of squares, filling most of the frame
+static cv::Mat createSyntheticCheckerboard(const cv::Size& size, const int checkerboardDimensions[2]) {
+    cv::Mat board(size, CV_8UC3, cv::Scalar(255, 255, 255));
+
+    int squareSize = std::min(size.width / (checkerboardDimensions[0] + 2), size.height / (checkerboardDimensions[1] + 2));
+    cv::Point origin((size.width - squareSize * checkerboardDimensions[0]) / 2, (size.height - squareSize * checkerboardDimensions[1]) / 2);
+
+    for (int row = 0; row < checkerboardDimensions[1]; row++) {
+        for (int col = 0; col < checkerboardDimensions[0]; col++) {
+            if ((row + col) % 2 == 0) {
+                cv::Rect square(origin.x + col * squareSize, origin.y + row * squareSize, squareSize, squareSize);
+                cv::rectangle(board, square, cv::Scalar(0, 0, 0), cv::FILLED);
+            }
+        }
+    }
+
+    return board;
+}
+
+
+/**
+ * @brief Counts the cv::Mat allocations of the pooled decode + mask stages once the pools are warm.
+ *
+ * Every frame is copied into a frame borrowed from one FramePool (standing in for video.read()) and masked into a
+ * frame borrowed from a second pool, like a streaming pipeline does. Should be 0.
+ *
+ * @param frame The frame used as the decoded video frame.
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param numFrames Number of frames processed after the warm up.
+ * @return std::size_t The number of cv::Mat buffer allocations during the numFrames frames.
+ */
+static std::size_t countSteadyStateAllocations(const cv::Mat& frame, const cv::Point3f& lower, const cv::Point3f& upper, int numFrames) {
+    FramePool framePool(4, frame.size(), frame.type());
+    FramePool maskPool(4, frame.size(), CV_8UC1);
+
+    auto processFrame = [&] {
+        std::size_t frameSlot = framePool.acquire();
+        std::size_t maskSlot = maskPool.acquire();
+        frame.copyTo(framePool.frame(frameSlot));
+        applyColorMaskFused(framePool.frame(frameSlot), lower, upper, maskPool.frame(maskSlot));
+        framePool.release(frameSlot);
+        maskPool.release(maskSlot);
+    };
+
+    // warm up, so lazily created OpenCV state does not count
+    processFrame();
+
+    // the default allocator is restored when the counter goes out of scope
+    MatAllocationCounter allocations;
+    for (int i = 0; i < numFrames; i++) {
+        processFrame();
+    }
+    return allocations.count();
+}
+
+
+// Number of values of two images that differ by more than tolerance; all of them if the sizes or types differ
+static std::size_t countMismatches(const cv::Mat& result, const cv::Mat& reference, double tolerance = 0.0) {
+    if (result.size() != reference.size() || result.type() != reference.type()) {
+        return std::max(result.total() * result.channels(), reference.total() * reference.channels());
+    }
+
+    cv::Mat difference;
+    cv::absdiff(result, reference, difference);
+    return static_cast<std::size_t>(cv::countNonZero(difference.reshape(1) > tolerance));
+}
+
+
+// Plain cv::cvtColor + cv::inRange mask of an HSV range; a hue range with lower.x > upper.x is the union of two ranges
+static cv::Mat referenceColorMask(const cv::Mat& hsvImage, const cv::Point3f& lower, const cv::Point3f& upper) {
+    cv::Mat mask;
+    if (lower.x > upper.x) {
+        cv::Mat upperPart;
+        cv::inRange(hsvImage, cv::Scalar(lower.x, lower.y, lower.z), cv::Scalar(255, upper.y, upper.z), mask);
+        cv::inRange(hsvImage, cv::Scalar(0, lower.y, lower.z), cv::Scalar(upper.x, upper.y, upper.z), upperPart);
+        mask |= upperPart;
+    }
+    else {
+        cv::inRange(hsvImage, cv::Scalar(lower.x, lower.y, lower.z), cv::Scalar(upper.x, upper.y, upper.z), mask);
+    }
+    return mask;
+}
+
+
+// Prints the outcome of one equivalence check; true if nothing differed
+static bool reportCheck(const std::string& name, const std::string& resolution, std::size_t mismatches) {
+    if (mismatches == 0) {
+        std::printf("%-38s %-6s OK\n", ("check " + name).c_str(), resolution.c_str());
+        return true;
+    }
+
+    std::printf("%-38s %-6s FAILED, %zu mismatches\n", ("check " + name).c_str(), resolution.c_str(), mismatches);
+    return false;
+}
+
+
+/**
+ * @brief Checks the optimized paths against the plain OpenCV implementations they replace.
+ *
+ * Masks must be bit-identical, centroids equal to 1e-3 pixels, contours must cover the same pixels when filled and
+ * warped quads may differ by at most one gray level. Every check is printed, failures with their mismatch count.
+ *
+ * @param frame The synthetic BGR frame.
+ * @param preprocessed The preprocessed (binary) frame for the contour checks.
+ * @param quads The quads for the warp check.
+ * @param resolution The name of the resolution, e.g. "1080p".
+ * @return bool true if every check passed.
+ */
+static bool checkOptimizedPaths(const cv::Mat& frame, const cv::Mat& preprocessed, const std::vector<std::vector<cv::Point2f>>& quads, const std::string& resolution) {
+    // orange, blue and a red range that wraps around hue 179 -> 0
+    const std::vector<std::pair<cv::Point3f, cv::Point3f>> ranges = {
+        { cv::Point3f(5, 100, 100), cv::Point3f(25, 255, 255) },
+        { cv::Point3f(100, 100, 100), cv::Point3f(130, 255, 255) },
+        { cv::Point3f(170, 100, 100), cv::Point3f(10, 255, 255) },
+    };
+
+    cv::Mat hsv;
+    cv::cvtColor(frame, hsv, cv::COLOR_BGR2HSV);
+    std::vector<cv::Mat> referenceMasks;
+    for (const auto& range : ranges) {
+        referenceMasks.push_back(referenceColorMask(hsv, range.first, range.second));
+    }
+
+    bool passed = true;
+
+    // applyColorMaskFused and findObjectPositionInColorRange vs cvtColor + inRange (+ moments)
+    std::size_t maskMismatches = 0;
+    std::size_t centroidMismatches = 0;
+    cv::Mat mask;
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+        applyColorMaskFused(frame, ranges[i].first, ranges[i].second, mask);
+        maskMismatches += countMismatches(mask, referenceMasks[i]);
+
+        cv::Point2f position = findObjectPositionInColorRange(frame, ranges[i].first, ranges[i].second);
+        cv::Point2f referencePosition = findObjectPosition(referenceMasks[i]);
+        if (std::abs(position.x - referencePosition.x) > 1e-3f || std::abs(position.y - referencePosition.y) > 1e-3f) {
+            centroidMismatches++;
+        }
+    }
+    passed = reportCheck("applyColorMaskFused vs inRange", resolution, maskMismatches) && passed;
+    passed = reportCheck("findObjectPositionInColorRange", resolution, centroidMismatches) && passed;
+
+    // ColorClassifier with the exact 8 bit table vs one inRange per class
+    ColorClassifier classifier(8);
+    for (const auto& range : ranges) {
+        classifier.addHSVRange(range.first, range.second);
+    }
+    classifier.compile();
+    std::vector<cv::Mat> classMasks;
+    classifier.classifyMasks(frame, classMasks);
+    std::size_t classMismatches = 0;
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+        classMismatches += countMismatches(classMasks[i], referenceMasks[i]);
+    }
+    passed = reportCheck("ColorClassifier masks vs inRange", resolution, classMismatches) && passed;
+
+    // findContoursTiled vs findContours on the whole image, compared as filled masks; small tiles so contours cross them
+    const double minArea = 1000.0;
+    std::vector<std::vector<cv::Point>> referenceContours;
+    cv::findContours(preprocessed, referenceContours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    referenceContours.erase(std::remove_if(referenceContours.begin(), referenceContours.end(),
+        [minArea](const std::vector<cv::Point>& contour) { return cv::contourArea(contour) <= minArea; }), referenceContours.end());
+
+    cv::Mat referenceFilled = cv::Mat::zeros(preprocessed.size(), CV_8UC1);
+    cv::Mat tiledFilled = cv::Mat::zeros(preprocessed.size(), CV_8UC1);
+    cv::drawContours(referenceFilled, referenceContours, -1, cv::Scalar(255), cv::FILLED);
+    cv::drawContours(tiledFilled, findContoursTiled(preprocessed, minArea, 128), -1, cv::Scalar(255), cv::FILLED);
+    passed = reportCheck("findContoursTiled vs findContours", resolution, countMismatches(tiledFilled, referenceFilled)) && passed;
+
+    // QuadWarper vs warpImage (cv::warpPerspective)
+    QuadWarper quadWarper;
+    std::vector<cv::Mat> warpedQuads;
+    const cv::Size warpSize(200, 200);
+    quadWarper.warp(frame, quads, warpSize, warpedQuads);
+    std::size_t warpMismatches = 0;
+    for (std::size_t i = 0; i < quads.size(); i++) {
+        warpMismatches += countMismatches(warpedQuads[i], warpImage(frame, quads[i], warpSize.width, warpSize.height), 1.0);
+    }
+    passed = reportCheck("QuadWarper vs warpPerspective", resolution, warpMismatches) && passed;
+
+    return passed;
+}
+
+
+/**
+ * @brief Checks that the multithreaded tracking pipeline gives the same positions as the sequential tracker.
+ *
+ * A short video with a moving ball is written and tracked with trackObjectPositionsStreaming() and with a
+ * TrackingPipeline; both must report the same position for every frame. Skipped (and counted as passed) if no
+ * MJPG video writer is available.
+ *
+ * @param size The frame size of the video.
+ * @param lower The lower bound for the HSV color range (as cv::Point3f).
+ * @param upper The upper bound for the HSV color range (as cv::Point3f).
+ * @param resolution The name of the resolution, e.g. "1080p".
+ * @return bool false if the positions differ.
+ */
+static bool checkPipelinedTracking(const cv::Size& size, const cv::Point3f& lower, const cv::Point3f& upper, const std::string& resolution) {
+    const std::string videoFile = "benchmark_video_" + resolution + ".avi";
+    const int numFrames = 30;
+
+    {
+        cv::VideoWriter writer(videoFile, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, size);
+        if (!writer.isOpened()) {
+            std::printf("%-38s %-6s skipped, no MJPG writer\n", "check pipelined vs sequential", resolution.c_str());
+            return true;
+        }
+
+        int radius = std::max(4, size.height / 30);
+        for (int i = 0; i < numFrames; i++) {
+            cv::Mat frame = createSyntheticFrame(size);
+            cv::circle(frame, cv::Point(size.width * (i + 1) / (numFrames + 2), size.height / 4), radius, cv::Scalar(0, 140, 255), cv::FILLED);
+            writer.write(frame);
+        }
+    }
+
+    std::vector<cv::Point2f> sequential, pipelined;
+    cv::VideoCapture sequentialVideo(videoFile);
+    cv::VideoCapture pipelinedVideo(videoFile);
+
+    trackObjectPositionsStreaming(sequentialVideo, lower, upper, [&](int, const cv::Point2f& position) {
+        sequential.push_back(position);
+        return true;
+    });
+
+    TrackingPipeline pipeline(lower, upper, 4);
+    pipeline.run(pipelinedVideo, [&](int, const cv::Point2f& position) {
+        pipelined.push_back(position);
+        return true;
+    });
+
+    sequentialVideo.release();
+    pipelinedVideo.release();
+    std::remove(videoFile.c_str());
+
+    std::size_t mismatches = sequential.size() > pipelined.size() ? sequential.size() - pipelined.size() : pipelined.size() - sequential.size();
+    for (std::size_t i = 0; i < std::min(sequential.size(), pipelined.size()); i++) {
+        if (sequential[i] != pipelined[i]) {
+            mismatches++;
+        }
+    }
+    if (sequential.empty()) {
+        mismatches++;
+    }
+
+    return reportCheck("pipelined vs sequential positions", resolution, mismatches);
+}
+
+
+static void printResult(const BenchmarkResult& result) {
+    std::printf("%-38s %-6s %6d %10.3f %10.3f %10.3f %10.3f %10.1f\n", result.name.c_str(), result.resolution.c_str(),
+        result.iterations, result.p50Ms, result.p90Ms, result.p99Ms, result.maxMs, result.megapixelsPerSecond);
+}
+
+
+// Writes all results as a JSON array so runs of different releases can be compared
+static bool saveResultsToJSON(const std::vector<BenchmarkResult>& results, const std::string& fileName) {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << fileName << " for writing." << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"opencv\": \"" << CV_VERSION << "\",\n  \"threads\": " << cv::getNumThreads() << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        file << "    {\"name\": \"" << r.name << "\", \"resolution\": \"" << r.resolution
+            << "\", \"width\": " << r.size.width << ", \"height\": " << r.size.height
+            << ", \"iterations\": " << r.iterations
+            << ", \"mean_ms\": " << r.meanMs << ", \"p50_ms\": " << r.p50Ms << ", \"p90_ms\": " << r.p90Ms
+            << ", \"p99_ms\": " << r.p99Ms << ", \"max_ms\": " << r.maxMs
+            << ", \"megapixels_per_second\": " << r.megapixelsPerSecond << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+
+    return true;
+}
+
+
+/**
+ * @brief Benchmarks the public functions of the numbered modules on synthetic images at VGA, 1080p and 4K.
+ *
+ * Before the timings of every resolution, the optimized paths are checked against their references; the run exits
+ * with 1 if any check failed, so a fast but wrong path cannot go unnoticed.
+ *
+ * Usage: main_benchmark [--json results.json] [--filter substring] [--iterations N]
+ */
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            options.jsonFileName = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--iterations" && i + 1 < argc) {
+            options.maxIterations = std::max(3, std::stoi(argv[++i]));
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--json results.json] [--filter substring] [--iterations N]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::pair<std::string, cv::Size>> resolutions = {
+        { "VGA", cv::Size(640, 480) },
+        { "1080p", cv::Size(1920, 1080) },
+        { "4K", cv::Size(3840, 2160) },
+    };
+
+    std::vector<BenchmarkResult> results;
+    bool allChecksPassed = true;
+
+    std::printf("%-38s %-6s %6s %10s %10s %10s %10s %10s\n", "function", "res", "iters", "p50 ms", "p90 ms", "p99 ms", "max ms", "MP/s");
+
+    for (const auto& resolution : resolutions) {
+        const std::string& resolutionName = resolution.first;
+        const cv::Size& size = resolution.second;
+
+        cv::Mat frame = createSyntheticFrame(size);
+        cv::Mat gray = convertToGrayscale(frame);
+        cv::Mat canny = applyCannyEdgeDetection(gray, 50, 100);
+        cv::Mat preprocessed = preprocessImageForContourDetection(frame);
+        cv::Mat drawing = frame.clone();
+
+        const cv::Point3f lower(5, 100, 100);
+        const cv::Point3f upper(25, 255, 255);
+        cv::Mat mask = applyColorMask(frame, lower, upper);
+        cv::Mat reusedMask;
+        cv::Mat reusedHSV;
+        cv::Mat labels;
+
+        // three marker colors classified together
+        ColorClassifier classifier;
+        classifier.addHSVRange(lower, upper);
+        classifier.addHSVRange(cv::Point3f(100, 100, 100), cv::Point3f(130, 255, 255));
+        classifier.addHSVRange(cv::Point3f(170, 100, 100), cv::Point3f(10, 255, 255));
+        classifier.compile();
+        ConstantVelocityKalmanTracker velocityTracker;
+        ConstantAccelerationKalmanTracker accelerationTracker;
+
+        const std::vector<cv::Point2f> quad = {
+            cv::Point2f(size.width * 0.2f, size.height * 0.1f), cv::Point2f(size.width * 0.8f, size.height * 0.15f),
+            cv::Point2f(size.width * 0.1f, size.height * 0.9f), cv::Point2f(size.width * 0.9f, size.height * 0.85f) };
+
+        // a grid of 24 quads warped as one batch, unchanged between iterations so the remap tables stay cached
+        std::vector<std::vector<cv::Point2f>> quads;
+        for (int row = 0; row < 4; row++) {
+            for (int col = 0; col < 6; col++) {
+                float x = size.width * col / 6.0f, y = size.height * row / 4.0f, w = size.width / 6.0f, h = size.height / 4.0f;
+                quads.push_back({ cv::Point2f(x + 0.1f * w, y), cv::Point2f(x + w, y + 0.1f * h), cv::Point2f(x, y + 0.9f * h), cv::Point2f(x + 0.9f * w, y + h) });
+            }
+        }
+        QuadWarper quadWarper;
+        std::vector<cv::Mat> warpedQuads;
+
+        allChecksPassed = checkOptimizedPaths(frame, preprocessed, quads, resolutionName) && allChecksPassed;
+        allChecksPassed = checkPipelinedTracking(size, lower, upper, resolutionName) && allChecksPassed;
+
+        const cv::Matx33f K(size.width * 0.8f, 0, size.width / 2.0f, 0, size.width * 0.8f, size.height / 2.0f, 0, 0, 1);
+        const cv::Vec<float, 5> k(-0.2f, 0.05f, 0, 0, 0);
+
+        const int checkerboardDimensions[2] = { 25, 18 };
+        const cv::Size patternSize(checkerboardDimensions[0] - 1, checkerboardDimensions[1] - 1);
+        const std::string checkerboardFile = "benchmark_checkerboard_" + resolutionName + ".png";
+        cv::imwrite(checkerboardFile, createSyntheticCheckerboard(size, checkerboardDimensions));
+        const std::vector<std::string> checkerboardFiles = { checkerboardFile };
+
+        const std::vector<std::pair<std::string, std::function<void()>>> cases = {
+            // 2_basic_functions
+            { "convertToGrayscale", [&] { convertToGrayscale(frame); } },
+            { "applyGaussianBlur", [&] { applyGaussianBlur(gray, cv::Size(5, 5), 0); } },
+            { "applyCannyEdgeDetection", [&] { applyCannyEdgeDetection(gray, 50, 100); } },
+            { "applyDialate", [&] { applyDialate(canny, 5); } },
+            { "applyErode", [&] { applyErode(canny, 1); } },
+            // 3_resize_crop
+            { "resizeImage", [&] { resizeImage(frame, cv::Size(512, 512)); } },
+            { "scaleImage", [&] { scaleImage(frame, 0.5, 0.5); } },
+            { "cropImage", [&] { cropImage(frame, cv::Rect(0, 0, size.width / 2, size.height / 2)); } },
+            // 4_draw_write
+            { "createImage", [&] { createImage(size.width, size.height, cv::Scalar(255, 255, 255)); } },
+            { "drawLineOnImage", [&] { drawLineOnImage(drawing, cv::Point(0, 0), cv::Point(size.width - 1, size.height - 1), cv::Scalar(0, 0, 255), 3); } },
+            { "drawRectangleOnImage", [&] { drawRectangleOnImage(drawing, cv::Point(10, 10), cv::Point(size.width / 2, size.height / 2), cv::Scalar(0, 255, 0), 3); } },
+            { "drawCircleOnImage", [&] { drawCircleOnImage(drawing, cv::Point(size.width / 2, size.height / 2), size.height / 4, cv::Scalar(255, 0, 0), 3); } },
+            { "drawTextOnImage", [&] { drawTextOnImage(drawing, "Computer Vision with C++", cv::Point(20, 40), cv::FONT_HERSHEY_COMPLEX, 1.0, cv::Scalar(0, 0, 0), 2); } },
+            // 5_warping
+            { "warpImage", [&] { warpImage(frame, quad, size.width / 2, size.height / 2); } },
+            { "QuadWarper::warp(24 quads, cached)", [&] { quadWarper.warp(frame, quads, cv::Size(200, 200), warpedQuads); } },
+            // 6_color_detection
+            { "ColorClassifier::classify(3 classes)", [&] { classifier.classify(frame, labels); } },
+            { "ColorClassifier::findCentroids(3 classes)", [&] { classifier.findCentroids(frame); } },
+            // 7_shape_contour_detection
+            { "preprocessImageForContourDetection", [&] { preprocessImageForContourDetection(frame); } },
+            { "findAndDrawContoursInPlace", [&] { findAndDrawContoursInPlace(preprocessed, drawing); } },
+            // 8_callibration_checkerboard
+            { "initUndistortMaps", [&] { cv::Mat mapX, mapY; initUndistortMaps(K, k, size, mapX, mapY); } },
+            { "detectCornersInImages", [&] { detectCornersInImages(checkerboardFiles, patternSize); } },
+            { "detectCornersInImages(coarse x2)", [&] { detectCornersInImages(checkerboardFiles, patternSize, 2); } },
+            // 9_pose_tracking
+            { "applyColorMask", [&] { applyColorMask(frame, lower, upper); } },
+            { "cvtColor + inRange(reused buffers)", [&] { cv::cvtColor(frame, reusedHSV, cv::COLOR_BGR2HSV); cv::inRange(reusedHSV, cv::Scalar(lower.x, lower.y, lower.z), cv::Scalar(upper.x, upper.y, upper.z), reusedMask); } },
+            { "applyColorMaskFused(reused mask)", [&] { applyColorMaskFused(frame, lower, upper, reusedMask); } },
+            { "findObjectPosition", [&] { findObjectPosition(mask); } },
+            { "findObjectPositionInColorRange", [&] { findObjectPositionInColorRange(frame, lower, upper); } },
+            // 12_kalman_tracking (1000 updates, so ms per call = us per update)
+            { "KalmanTracker<4>::update x1000", [&] { for (int i = 0; i < 1000; i++) velocityTracker.update(cv::Point2f(100.0f + i, 200.0f + 0.5f * i)); } },
+            { "KalmanTracker<6>::update x1000", [&] { for (int i = 0; i < 1000; i++) accelerationTracker.update(cv::Point2f(100.0f + i, 200.0f + 0.5f * i)); } },
+        };
+
+        for (const auto& benchmarkCase : cases) {
+            if (!options.filter.empty() && benchmarkCase.first.find(options.filter) == std::string::npos) {
+                continue;
+            }
+
+            BenchmarkResult result = runBenchmark(benchmarkCase.first, resolutionName, size, options, benchmarkCase.second);
+            printResult(result);
+            results.push_back(result);
+        }
+
+        std::remove(checkerboardFile.c_str());
+
+        printSpeedup(results, resolutionName, "cvtColor + inRange(reused buffers)", "applyColorMaskFused(reused mask)");
+
+        if (options.filter.empty() || std::string("FramePool").find(options.filter) != std::string::npos) {
+            std::printf("%-38s %-6s %zu cv::Mat allocations in 100 frames\n", "FramePool steady state", resolutionName.c_str(),
+                countSteadyStateAllocations(frame, lower, upper, 100));
+        }
+    }
+
+    if (!options.jsonFileName.empty() && saveResultsToJSON(results, options.jsonFileName)) {
+        std::cout << "Results saved to " << options.jsonFileName << std::endl;
+    }
+
+    if (!allChecksPassed) {
+        std::cerr << "Error: At least one optimized path does not match its reference, see the FAILED checks above." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
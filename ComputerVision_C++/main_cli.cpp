@@ -0,0 +1,464 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/calib3d.hpp>
+
+#include "5_warping.h"
+#include "7_shape_contour_detection.h"
+#include "8_callibration_checkerboard.h"
+#include "9_pose_tracking.h"
+#include "10_pipeline_tracking.h"
+#include "13_multi_object_tracking.h"
+#include "15_telemetry.h"
+
+
+// Positional arguments and --options of a subcommand. Options without a value (e.g. --display) map to "".
+struct CommandLine {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> options;
+
+    bool has(const std::string& name) const { return options.count(name) > 0; }
+
+    std::string get(const std::string& name, const std::string& defaultValue) const {
+        auto it = options.find(name);
+        return it == options.end() ? defaultValue : it->second;
+    }
+};
+
+// Options that take no value
+static const std::vector<std::string> flagOptions = { "--display", "--roi" };
+
+
+static CommandLine parseCommandLine(int argc, char** argv, int first) {
+    CommandLine commandLine;
+
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            bool isFlag = std::find(flagOptions.begin(), flagOptions.end(), arg) != flagOptions.end();
+            commandLine.options[arg] = (!isFlag && i + 1 < argc) ? argv[++i] : "";
+        }
+        else {
+            commandLine.positional.push_back(arg);
+        }
+    }
+
+    return commandLine;
+}
+
+
+// true if the next character of the stream is the expected separator
+static bool readSeparator(std::istream& stream, char expected) {
+    char separator = 0;
+    stream >> separator;
+    return !stream.fail() && separator == expected;
+}
+
+
+// true if all numbers were read and nothing but whitespace is left
+static bool isFullyParsed(std::istream& stream) {
+    if (stream.fail()) {
+        return false;
+    }
+    stream >> std::ws;
+    return stream.eof();
+}
+
+
+// "h,s,v" -> cv::Point3f; false if the text is not three comma separated numbers
+static bool parsePoint3f(const std::string& text, cv::Point3f& point) {
+    std::istringstream stream(text);
+    stream >> point.x;
+    if (!readSeparator(stream, ',')) {
+        return false;
+    }
+    stream >> point.y;
+    if (!readSeparator(stream, ',')) {
+        return false;
+    }
+    stream >> point.z;
+    return isFullyParsed(stream);
+}
+
+
+// "WxH" -> cv::Size; false if the text is not two positive integers separated by 'x'
+static bool parseSize(const std::string& text, cv::Size& size) {
+    std::istringstream stream(text);
+    stream >> size.width;
+    if (!readSeparator(stream, 'x')) {
+        return false;
+    }
+    stream >> size.height;
+    return isFullyParsed(stream) && size.width > 0 && size.height > 0;
+}
+
+
+// "x1,y1,x2,y2,x3,y3,x4,y4" -> 4 points; false if the text is not eight comma separated numbers
+static bool parseQuad(const std::string& text, std::vector<cv::Point2f>& points) {
+    points.assign(4, cv::Point2f());
+    std::istringstream stream(text);
+    for (int i = 0; i < 4; i++) {
+        if (i > 0 && !readSeparator(stream, ',')) {
+            return false;
+        }
+        stream >> points[i].x;
+        if (!readSeparator(stream, ',')) {
+            return false;
+        }
+        stream >> points[i].y;
+    }
+    return isFullyParsed(stream);
+}
+
+
+// A single image file or every image of a folder
+static std::vector<std::string> getInputImagePaths(const std::string& path) {
+    if (cv::haveImageReader(path)) {
+        return { path };
+    }
+    return getImagePathsFromFolder(path);
+}
+
+
+static std::string getBaseName(const std::string& path) {
+    return path.substr(path.find_last_of("/\\") + 1);
+}
+
+
+// track <video file | camera id> <positions.txt> [--lower h,s,v] [--upper h,s,v] [--roi] [--workers N] [--multi MIN_AREA] [--display]
+static int runTrack(const CommandLine& commandLine) {
+    if (commandLine.positional.size() < 2) {
+        std::cerr << "Usage: track <video file | camera id> <positions.txt> [--lower h,s,v] [--upper h,s,v] [--roi] [--workers N] [--multi MIN_AREA] [--display]" << std::endl;
+        return 1;
+    }
+
+    const std::string& source = commandLine.positional[0];
+    cv::VideoCapture video;
+    if (!source.empty() && source.find_first_not_of("0123456789") == std::string::npos) {
+        video.open(std::stoi(source));
+    }
+    else {
+        video.open(source);
+    }
+
+    cv::Point3f lower, upper;
+    if (!parsePoint3f(commandLine.get("--lower", "0,108,150"), lower) || !parsePoint3f(commandLine.get("--upper", "179,255,255"), upper)) {
+        std::cerr << "Error: --lower and --upper must be h,s,v (e.g. 0,108,150)." << std::endl;
+        return 1;
+    }
+    bool display = commandLine.has("--display");
+
+    // every object in the color range with its track id, one "frame,id,x,y,area" line per object
+    if (commandLine.has("--multi")) {
+        int frameCount = trackMultipleObjectsToFile(video, lower, upper, commandLine.positional[1], std::stoi(commandLine.get("--multi", "50")));
+        std::cout << "Tracked " << frameCount << " frames" << std::endl;
+        return frameCount < 0 ? 1 : 0;
+    }
+
+    // headless full speed paths: multithreaded pipeline or single threaded streaming
+    if (!display && commandLine.has("--workers")) {
+        int frameCount = trackObjectPositionsPipelined(video, lower, upper, commandLine.positional[1], std::stoi(commandLine.get("--workers", "0")));
+        std::cout << "Tracked " << frameCount << " frames" << std::endl;
+        return frameCount < 0 ? 1 : 0;
+    }
+
+    if (!display && !commandLine.has("--roi")) {
+        int frameCount = trackObjectPositionsToFile(video, lower, upper, commandLine.positional[1]);
+        std::cout << "Tracked " << frameCount << " frames" << std::endl;
+        return frameCount < 0 ? 1 : 0;
+    }
+
+    if (!video.isOpened()) {
+        std::cerr << "Error: Cannot open the video source " << source << std::endl;
+        return 1;
+    }
+
+    std::ofstream file(commandLine.positional[1]);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << commandLine.positional[1] << " for writing." << std::endl;
+        return 1;
+    }
+
+    PredictiveColorTracker tracker(lower, upper);
+    cv::Mat frame;
+    int frameCount = 0;
+
+    while (video.read(frame)) {
+        cv::Point2f position = commandLine.has("--roi") ? tracker.track(frame) : findObjectPositionInColorRange(frame, lower, upper);
+        file << position.x << "," << position.y << "\n";
+        frameCount++;
+
+        if (display) {
+            if (position.x >= 0) {
+                cv::circle(frame, position, 10, cv::Scalar(0, 255, 0), 2);
+            }
+            cv::imshow("Tracking", frame);
+            if (cv::waitKey(1) == 27) {
+                break;
+            }
+        }
+    }
+
+    std::cout << "Tracked " << frameCount << " frames" << std::endl;
+    return 0;
+}
+
+
+// calibrate <image folder> <calibration.bin> [--board 25x18] [--downscale 2] [--yaml file] [--display]
+static int runCalibrate(const CommandLine& commandLine) {
+    if (commandLine.positional.size() < 2) {
+        std::cerr << "Usage: calibrate <image folder> <calibration.bin> [--board 25x18] [--downscale 2] [--yaml file] [--display]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> fileNames = getImagePathsFromFolder(commandLine.positional[0]);
+    if (fileNames.empty()) {
+        std::cerr << "Error: No images found in " << commandLine.positional[0] << std::endl;
+        return 1;
+    }
+
+    cv::Size board;
+    if (!parseSize(commandLine.get("--board", "25x18"), board) || board.width < 2 || board.height < 2) {
+        std::cerr << "Error: --board must be COLSxROWS squares, at least 2x2 (e.g. 25x18)." << std::endl;
+        return 1;
+    }
+    int checkerboardDimensions[2] = { board.width, board.height };
+    cv::Size patternSize(board.width - 1, board.height - 1);
+    int downscaleFactor = std::stoi(commandLine.get("--downscale", "2"));
+
+    std::vector<std::vector<cv::Point3f>> Q;
+    std::vector<std::vector<cv::Point2f>> q;
+    std::vector<cv::Point3f> objp = generateWorldCoordinates(checkerboardDimensions);
+
+    for (CornerDetection& detection : detectCornersInImages(fileNames, patternSize, downscaleFactor)) {
+        std::cout << detection.fileName << (detection.patternFound ? " found" : " not found")
+            << " (" << detection.detectionTimeMs << " ms)" << std::endl;
+
+        if (commandLine.has("--display")) {
+            cv::Mat img = cv::imread(detection.fileName);
+            cv::drawChessboardCorners(img, patternSize, detection.corners, detection.patternFound);
+            cv::imshow("chessboard detection", img);
+            cv::waitKey(0);
+        }
+
+        if (detection.patternFound) {
+            q.push_back(std::move(detection.corners));
+            Q.push_back(objp);
+        }
+    }
+
+    if (q.empty()) {
+        std::cerr << "Error: The checkerboard was not found in any image." << std::endl;
+        return 1;
+    }
+
+    // all calibration images are expected to have the same size
+    cv::Size frameSize = cv::imread(fileNames[0], cv::IMREAD_GRAYSCALE).size();
+
+    cv::Matx33f K(cv::Matx33f::eye());
+    cv::Vec<float, 5> k(0, 0, 0, 0, 0);
+    float error = calibrateCameraAndComputeErrors(Q, q, frameSize, K, k);
+
+    std::cout << "Reprojection error = " << error << "\nK =\n"
+        << K << "\nk=\n"
+        << k << std::endl;
+
+    std::vector<CameraCalibration> cameras = { { getBaseName(commandLine.positional[0]), K, k, frameSize } };
+    if (!saveCameraCalibrationsBinary(commandLine.positional[1], cameras)) {
+        return 1;
+    }
+
+    if (commandLine.has("--yaml") && !exportCameraCalibrationsYAML(commandLine.get("--yaml", ""), cameras)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// undistort <calibration.bin> <image file | folder> <output folder> [--camera 0] [--cache maps.bin] [--display]
+static int runUndistort(const CommandLine& commandLine) {
+    if (commandLine.positional.size() < 3) {
+        std::cerr << "Usage: undistort <calibration.bin> <image file | folder> <output folder> [--camera 0] [--cache maps.bin] [--display]" << std::endl;
+        return 1;
+    }
+
+    cv::Matx33f K;
+    cv::Vec<float, 5> k;
+    cv::Size frameSize;
+    if (!loadCameraCalibration(commandLine.positional[0], K, k, frameSize, std::stoi(commandLine.get("--camera", "0")))) {
+        return 1;
+    }
+
+    cv::Mat map1, map2;
+    if (commandLine.has("--cache")) {
+        initUndistortMapsCached(K, k, frameSize, commandLine.get("--cache", ""), map1, map2);
+    }
+    else {
+        cv::initUndistortRectifyMap(K, k, cv::Matx33f::eye(), K, frameSize, CV_16SC2, map1, map2);
+    }
+
+    std::vector<std::string> fileNames = getInputImagePaths(commandLine.positional[1]);
+    if (fileNames.empty()) {
+        std::cerr << "Error: No images found in " << commandLine.positional[1] << std::endl;
+        return 1;
+    }
+
+    int undistortedCount = undistortImages(fileNames, map1, map2, commandLine.positional[2], commandLine.has("--display"));
+
+    std::cout << "Undistorted " << undistortedCount << " of " << fileNames.size() << " images" << std::endl;
+    return undistortedCount == static_cast<int>(fileNames.size()) ? 0 : 1;
+}
+
+
+// contours <image file | folder> <output folder> [--min-area 1000] [--display]
+static int runContours(const CommandLine& commandLine) {
+    if (commandLine.positional.size() < 2) {
+        std::cerr << "Usage: contours <image file | folder> <output folder> [--min-area 1000] [--display]" << std::endl;
+        return 1;
+    }
+
+    double minArea = std::stod(commandLine.get("--min-area", "1000"));
+    std::vector<std::string> fileNames = getInputImagePaths(commandLine.positional[0]);
+    if (fileNames.empty()) {
+        std::cerr << "Error: No images found in " << commandLine.positional[0] << std::endl;
+        return 1;
+    }
+
+    int processedCount = 0;
+    for (const std::string& fileName : fileNames) {
+        cv::Mat bgrImage = cv::imread(fileName, cv::IMREAD_COLOR);
+        if (bgrImage.empty()) {
+            std::cerr << "Error: Cannot read " << fileName << std::endl;
+            continue;
+        }
+
+        cv::Mat preprocessedImage = preprocessImageForContourDetection(bgrImage, 50, 100, 3, 1);
+        cv::Mat contouredImage = findAndDrawContours(preprocessedImage, bgrImage, minArea);
+
+        std::string outputFileName = commandLine.positional[1] + "/" + getBaseName(fileName);
+        if (!cv::imwrite(outputFileName, contouredImage)) {
+            std::cerr << "Error: Cannot write " << outputFileName << std::endl;
+            continue;
+        }
+        processedCount++;
+
+        if (commandLine.has("--display")) {
+            cv::imshow("Contours", contouredImage);
+            cv::waitKey(0);
+        }
+    }
+
+    std::cout << "Processed " << processedCount << " of " << fileNames.size() << " images" << std::endl;
+    return processedCount == static_cast<int>(fileNames.size()) ? 0 : 1;
+}
+
+
+// warp <image> <output image> <x1,y1,x2,y2,x3,y3,x4,y4> <WxH> [--display]
+static int runWarp(const CommandLine& commandLine) {
+    if (commandLine.positional.size() < 4) {
+        std::cerr << "Usage: warp <image> <output image> <x1,y1,x2,y2,x3,y3,x4,y4> <WxH> [--display]" << std::endl;
+        return 1;
+    }
+
+    cv::Mat inputImage = cv::imread(commandLine.positional[0], cv::IMREAD_COLOR);
+    if (inputImage.empty()) {
+        std::cerr << "Error: Cannot read " << commandLine.positional[0] << std::endl;
+        return 1;
+    }
+
+    // Sequence of points should be top-left, top-right, bottom-left, bottom-right
+    std::vector<cv::Point2f> sourcePoints;
+    if (!parseQuad(commandLine.positional[2], sourcePoints)) {
+        std::cerr << "Error: The quad must be x1,y1,x2,y2,x3,y3,x4,y4, got " << commandLine.positional[2] << std::endl;
+        return 1;
+    }
+
+    cv::Size outputSize;
+    if (!parseSize(commandLine.positional[3], outputSize)) {
+        std::cerr << "Error: The output size must be WxH, got " << commandLine.positional[3] << std::endl;
+        return 1;
+    }
+
+    cv::Mat warpedImage = warpImage(inputImage, sourcePoints, outputSize.width, outputSize.height);
+    if (!cv::imwrite(commandLine.positional[1], warpedImage)) {
+        std::cerr << "Error: Cannot write " << commandLine.positional[1] << std::endl;
+        return 1;
+    }
+
+    if (commandLine.has("--display")) {
+        cv::imshow("Warped Image", warpedImage);
+        cv::waitKey(0);
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Headless command line driver for the tracking, calibration, undistortion, contour and warping pipelines.
+ *
+ * Nothing is displayed unless --display is passed, so it can run in batch jobs on machines without a screen.
+ */
+int main(int argc, char** argv) {
+    const std::map<std::string, int (*)(const CommandLine&)> commands = {
+        { "track", runTrack },
+        { "calibrate", runCalibrate },
+        { "undistort", runUndistort },
+        { "contours", runContours },
+        { "warp", runWarp },
+    };
+
+    if (argc < 2 || commands.count(argv[1]) == 0) {
+        std::cerr << "Usage: " << argv[0] << " <track | calibrate | undistort | contours | warp> [arguments] [--display] [--telemetry stats.json] [--trace trace.json]" << std::endl;
+        return 1;
+    }
+
+    CommandLine commandLine = parseCommandLine(argc, argv, 2);
+    int result = 1;
+
+    // the trace keeps only the most recent events of every thread, so long runs stay bounded in memory
+    if (commandLine.has("--trace")) {
+        Telemetry::instance().enableTrace(1 << 16);
+    }
+
+    // std::stoi / std::stod on a malformed number, and OpenCV errors such as an output file without a known extension
+    try {
+        result = commands.at(argv[1])(commandLine);
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << "Error: Invalid number in the arguments (" << e.what() << ")." << std::endl;
+    }
+    catch (const std::out_of_range& e) {
+        std::cerr << "Error: Number out of range in the arguments (" << e.what() << ")." << std::endl;
+    }
+    catch (const cv::Exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    // per-stage timings are only recorded in builds with ENABLE_TELEMETRY defined
+    if (commandLine.has("--telemetry") || commandLine.has("--trace")) {
+#ifndef ENABLE_TELEMETRY
+        std::cerr << "Warning: built without ENABLE_TELEMETRY, no stage timings were recorded." << std::endl;
+#endif
+        Telemetry::instance().printStatistics();
+        if (commandLine.has("--telemetry")) {
+            Telemetry::instance().saveJSON(commandLine.get("--telemetry", "telemetry.json"));
+        }
+        if (commandLine.has("--trace")) {
+            Telemetry::instance().saveChromeTrace(commandLine.get("--trace", "trace.json"));
+        }
+    }
+
+    return result;
+}